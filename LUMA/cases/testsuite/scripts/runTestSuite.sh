@@ -118,6 +118,15 @@ do
 		NPROCS=1
 	elif [ ${CASE_NUM_INT} -eq 6 ] || [ ${CASE_NUM_INT} -eq 7 ] || [ ${CASE_NUM_INT} -eq 8 ] || [ ${CASE_NUM_INT} -eq 9 ]; then
 		NPROCS=8
+	elif [ ${CASE_NUM_INT} -eq 10 ] || [ ${CASE_NUM_INT} -eq 11 ] || [ ${CASE_NUM_INT} -eq 12 ] || [ ${CASE_NUM_INT} -eq 13 ] || [ ${CASE_NUM_INT} -eq 14 ]; then
+		NPROCS=4
+	fi
+
+	# Tolerance on the results (mixed precision cases are checked against a double precision base)
+	if [ ${CASE_NUM_INT} -eq 10 ]; then
+		DIFF_TOL=1e-6
+	else
+		DIFF_TOL=0
 	fi
 
 
@@ -154,8 +163,24 @@ do
 			# Checking results
 			printf "Runnning a diff on the results..."
 
-			# Perform the diff and collect the output
-			if diff -q ${DIR_BASE}/case${CASE_NUM}/${DIFF_FILE} ${DIR_OUT}/${DIFF_FILE} > /dev/null; then
+			# Perform the diff (or a numerical comparison if using a tolerance) and collect the output
+			if [ ${DIFF_TOL} = 0 ]; then
+				diff -q ${DIR_BASE}/case${CASE_NUM}/${DIFF_FILE} ${DIR_OUT}/${DIFF_FILE} > /dev/null
+			else
+				awk -v tol=${DIFF_TOL} '
+					NR == FNR { base[FNR] = $0; nbase = FNR; next }
+					{
+						if (split(base[FNR], b) != NF) bad = 1
+						for (i = 1; i <= NF && !bad; i++)
+						{
+							if ($i == b[i]) continue
+							d = $i - b[i]; if (d < 0) d = -d
+							if (d == 0 || d > tol) bad = 1
+						}
+					}
+					END { exit (bad || FNR != nbase) }' ${DIR_BASE}/case${CASE_NUM}/${DIFF_FILE} ${DIR_OUT}/${DIFF_FILE}
+			fi
+			if [ $? -eq 0 ]; then
 
 				# Check passed
 				printf "success!\n"
@@ -94,6 +94,21 @@ enum eType
 	eSlip					///< Slip boundary
 };
 
+/// \enum  eLinkType
+/// \brief	Treatment of a streaming link.
+///
+///			Listed in order of precedence when a link qualifies for more than one.
+enum eLinkType
+{
+	eBFLLink,			///< Link touching a BFL site
+	eSlipLink,			///< Link of a slip site
+	eBounceBackLink,	///< Link pulling from a solid site
+	eVelocityLink,		///< Link pulling from a forced equilibrium velocity site
+	eExplodeLink,		///< Link pulling from the parent grid
+	eCoalesceLink,		///< Link pulling from the child grid
+	eRegularLink		///< Regular pull from the source site
+};
+
 /// \enum eWallLocation
 /// \brief Enumeration to describe locations in terms of domain walls.
 enum eWallLocation
@@ -179,4 +194,12 @@ enum eSDReturnType {
 	eSDEarlyExit
 };
 
+///	\enum eHaloExchange
+///	\brief	Backends for the exchange of halo messages between ranks.
+enum eHaloExchange {
+	ePointToPoint,			///< Persistent sends and receives to each neighbour
+	eNeighbourCollective,	///< Neighbourhood collective on a distributed graph communicator of each grid
+	eFastestExchange		///< Time both backends at start up and use the faster
+};
+
 #endif
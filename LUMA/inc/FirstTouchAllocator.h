@@ -0,0 +1,101 @@
+/*
+* --------------------------------------------------------------
+*
+* ------ Lattice Boltzmann @ The University of Manchester ------
+*
+* -------------------------- L-U-M-A ---------------------------
+*
+* Copyright 2018 The University of Manchester
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.*
+*/
+
+#ifndef FIRST_TOUCH_ALLOCATOR_H
+#define FIRST_TOUCH_ALLOCATOR_H
+
+#include "stdafx.h"
+
+/// \brief	Allocator leaving grid fields untouched until they are placed.
+///
+///			Memory is obtained uninitialised and elements constructed without 
+///			arguments are default-initialised, so resizing an IVector through 
+///			IVector::resizeUninitialised() writes nothing. The operating 
+///			system places each page on the NUMA node of the thread that first 
+///			touches it, which leaves the grid free to touch its fields with the
+///			site loop of the kernel (see GridObj::LBM_initFirstTouch()).
+template <typename T>
+class FirstTouchAllocator
+{
+
+public:
+
+	typedef T value_type;	///< Type of the allocated elements
+
+	/// Default constructor
+	FirstTouchAllocator() noexcept
+	{
+	}
+
+	/// Converting constructor required by the allocator requirements
+	template <typename U>
+	FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept
+	{
+	}
+
+	/// \brief	Allocate uninitialised storage for n elements.
+	///
+	/// \param	n	number of elements.
+	/// \return	pointer to the uninitialised storage.
+	T *allocate(std::size_t n)
+	{
+		return static_cast<T *>(::operator new(n * sizeof(T)));
+	}
+
+	/// \brief	Default-initialise an element so no value is written.
+	///
+	/// \param	p	pointer to the element.
+	template <typename U>
+	void construct(U *p)
+	{
+		::new (static_cast<void *>(p)) U;
+	}
+
+	/// \brief	Construct an element from the given arguments.
+	///
+	/// \param	p		pointer to the element.
+	/// \param	args	constructor arguments.
+	template <typename U, typename... Args>
+	void construct(U *p, Args&&... args)
+	{
+		::new (static_cast<void *>(p)) U(std::forward<Args>(args)...);
+	}
+
+	/// \brief	Release storage obtained from allocate().
+	///
+	/// \param	p	pointer to the storage.
+	void deallocate(T *p, std::size_t)
+	{
+		::operator delete(p);
+	}
+
+};
+
+/// All instances are interchangeable
+template <typename T, typename U>
+inline bool operator==(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&) { return true; }
+
+/// All instances are interchangeable
+template <typename T, typename U>
+inline bool operator!=(const FirstTouchAllocator<T>&, const FirstTouchAllocator<U>&) { return false; }
+
+#endif
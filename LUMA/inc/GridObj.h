@@ -63,6 +63,15 @@ private :
 	int CoarseLimsY[2];		///< Local Y indices corresponding to where this grid is locate on parent grid
 	int CoarseLimsZ[2];		///< Local Z indices corresponding to where this grid is locate on parent grid
 
+	// Grid-to-grid coupling maps
+	std::vector<int> subGridIdx;	///< Position in subGrid of the child grid covering each site (-1 if none)
+	std::vector<int> coarseIdxX;	///< Parent x-index of the site enclosing each x-index of this grid
+	std::vector<int> coarseIdxY;	///< Parent y-index of the site enclosing each y-index of this grid
+	std::vector<int> coarseIdxZ;	///< Parent z-index of the site enclosing each z-index of this grid
+	std::vector<int> fineIdxX;		///< First x-index on this grid of the children of each parent x-index
+	std::vector<int> fineIdxY;		///< First y-index on this grid of the children of each parent y-index
+	std::vector<int> fineIdxZ;		///< First z-index on this grid of the children of each parent z-index
+
 	// 1D arrays
 public :
 	std::vector<double> XPos;	///< Vector of global X positions of each site
@@ -77,17 +86,63 @@ private :
 
 	// Vector nodal properties
 	// Flattened 4D arrays (i,j,k,vel)
-	IVector<double> f;				///< Distribution functions
+	IVector<popType> f;				///< Distribution functions
 	IVector<double> feq;			///< Equilibrium distribution functions
-	IVector<double> fNew;			///< Copy of distribution functions
+	IVector<popType> fNew;			///< Copy of distribution functions (not allocated with L_INPLACE_STREAMING)
 	IVector<double> u;				///< Macropscopic velocity components
 	IVector<double> u_n;			///< Macropscopic velocity components at start of current time step
 	IVector<double> force_xyz;		///< Macroscopic body force components
 	IVector<double> force_i;		///< Mesoscopic body force components
 
+	// Streaming connectivity
+	int streamOffset[L_NUM_VELS];	///< Offset in flattened ijk index from an interior site to its upstream site
+	std::vector<int> streamSrcX;	///< Upstream x-index for each (i,vel) with periodic wrap applied
+	std::vector<int> streamSrcY;	///< Upstream y-index for each (j,vel) with periodic wrap applied
+	std::vector<int> streamSrcZ;	///< Upstream z-index for each (k,vel) with periodic wrap applied
+
+	// Cache blocking
+	int tileSize[3];				///< Extent of a tile of the site loop in each direction
+	std::vector<int> tiles;			///< Flattened list of (i0,i1,j0,j1,k0,k1) site ranges of each tile in loop order
+	std::vector<bool> tileCoupled;	///< Flag per tile indicating it holds sites covered by a sub-grid
+
+	// Sparse storage
+	bool bSparse = false;			///< Flag to indicate populations are only stored for active sites
+	int numStoredSites;				///< Number of sites held in each population array
+	std::vector<int> sparseIdx;		///< Storage index of each site (inactive sites share the last one)
+	std::vector<int> sparseSites;	///< Flattened list of (i,j,k) indices of active sites
+
+	// Communication overlap
+	std::vector<int> shellTiles;	///< Tiles of sites on the sender or receiver layers of the MPI halo
+	std::vector<int> innerTiles;	///< Tiles of sites the MPI halo exchange does not touch
+	int sparseShellEnd = 0;			///< Position in sparseSites of the first site off the MPI halo (halo sites come first)
+
+	// Boundary links
+	std::vector<int> linkStart;			///< Position of the first boundary link of each site in the link lists (size N_lim*M_lim*K_lim+1)
+	std::vector<int> linkDir;			///< Lattice direction of each boundary link
+	std::vector<eLinkType> linkType;	///< Treatment of each boundary link
+
+#ifdef L_COLLIDE_BATCH
+	/// \struct CollideBatch
+	/// \brief	Streamed sites held back by a thread to be collided together.
+	///
+	///			Populations and moments are stored direction by direction so the
+	///			collision can be vectorised across the sites of the batch.
+	struct CollideBatch
+	{
+		double f[L_NUM_VELS][L_COLLIDE_BATCH];	///< Post-stream populations of each site
+		double rho[L_COLLIDE_BATCH];			///< Density of each site
+		double u[L_DIMS][L_COLLIDE_BATCH];		///< Velocity of each site
+		int site[4][L_COLLIDE_BATCH];			///< i, j, k and flattened ijk index of each site
+		int size = 0;							///< Number of sites held
+	};
+#else
+	struct CollideBatch;	///< Not used unless collisions are batched
+#endif
+
 	// Scalar nodal properties
 	// Flattened 3D arrays (i,j,k)
 	IVector<double> rho;			///< Macroscopic density
+	bool bStoreMacro = true;		///< Flag to write macroscopic quantities back to the grid on this time step
 
 	// Time averaged statistics
 	IVector<double> rho_timeav;		///< Time-averaged density at each grid point (i,j,k)
@@ -117,6 +172,7 @@ public :
 	// Timing variables
 	double timeav_mpi_overhead;		///< Time-averaged time of MPI communication
 	double timeav_timestep;			///< Time-averaged time of a timestep
+	double step_secs;				///< Time spent so far on the current step when advanced concurrently
 
 	// Local grid sizes
 	int N_lim;			///< Local size of grid in X-direction
@@ -141,6 +197,10 @@ public :
 	void LBM_initBoundLab();					// Initialise labels for walls
 	void LBM_initRefinedLab(GridObj& pGrid);	// Initialise labels for refined regions
 	eType LBM_setBCPrecedence(eType currentBC, eType desiredBC);		// Determine BC based on any existing BC
+	void LBM_initBoundaryLinks();				// Build the lists of links needing special treatment
+	void LBM_initSparseStorage();				// Compact population storage to active sites where worthwhile
+	void LBM_initRefinementBlocks();			// Trim the refined regions to the blocks which need them
+	void LBM_initFirstTouch();					// Place the fields on the NUMA nodes of the threads updating them
 
 	// LBM operations
 	DEPRECATED void LBM_kbcCollide(int i, int j, int k, IVector<double>& f_new);		// KBC collision operator
@@ -150,6 +210,12 @@ public :
 	// Multi-grid operations
 	void LBM_addSubGrid(int RegionNumber);				// Add and initialise subgrid structure for a given region number
 
+	// Population array access
+	inline int LBM_popIdx(int id, int v) const;							// Flattened index of population v at site id
+	inline int LBM_popIdx(int i, int j, int k, int v) const;			// Flattened index of population v at site (i,j,k)
+	int LBM_fIdx(int i, int j, int k, int v) const;						// Index in f of post-collision population v at site (i,j,k)
+	inline bool LBM_isStored(int i, int j, int k) const;				// Whether populations are stored for site (i,j,k)
+
 	// IO methods
 	void io_textout(std::string output_tag);	// Writes out the contents of the class as well as any subgrids to a text file
 	void io_fgaout();							// Wrapper for _io_fgaout with 2/3D checking 
@@ -162,32 +228,125 @@ private :
 
 	void _LBM_initGetInletProfileFromFile();		// Set inlet profile data from file
 	void _LBM_initSetInletProfile();				// Set the inlet profile data used for velocity BCs
+	void _LBM_initStreamTables();					// Build the streaming connectivity tables
+	void _LBM_initTiles();							// Choose the cache blocking of the site loop
+	void _LBM_initOverlap();						// Split the site loop into the MPI halo and the interior
+	void _LBM_initCouplingMaps(GridObj& pGrid);		// Build the index maps to and from the parent grid
+	int _LBM_getBlock(double x, double y, double z, const int *numBlocks);			// Refinement block of a position
+	int _LBM_getBlock(double xyz, eCartesianDirection dir, int numBlocks);		// Refinement block of a position in one direction
+	void _LBM_applyRefinementBlocks(const std::vector<bool> &kept, const int *numBlocks);	// Hand the sites of dropped blocks back to the parent
+	template <typename T>
+	void _LBM_compactPopulations(IVector<T> &pop);	// Move a population array into sparse storage
+	template <typename T>
+	void _LBM_firstTouch(IVector<T> &field, int width, bool bPopulations);	// Move a field to memory first touched by the kernel site loop
 	void _LBM_updateReynolds(double newReynolds);		// Updates the reynolds number at run time
 	void _io_fgaout(int timeStepL0);		// Writes out the macroscopic velocity components for the class as well as any subgrids 
 											// to a different .fga file for each subgrid. .fga format is the one used for Unreal 
 											// Engine 4 VectorField object.
 	// Private optimised LBM functions
-	void _LBM_stream_opt(int i, int j, int k, int id, eType type_local, int subcycle);
-	void _LBM_coalesce_opt(int i, int j, int k, int id, int v);
-	void _LBM_explode_opt(int id, int v, int src_x, int src_y, int src_z);
-	void _LBM_collide_opt(int id);
-	void _LBM_macro_opt(int i, int j, int k, int id, eType type_local);
-	void _LBM_forceGrid_opt(int id);
+	void _LBM_streamSite_opt(int i, int j, int k, int subcycle, CollideBatch *batch = nullptr);
+	void _LBM_collideStreamedSite_opt(int i, int j, int k, CollideBatch *batch = nullptr);
+	void _LBM_kernelPass_opt(const std::vector<int> &tileList, int sparseBegin, int sparseEnd, int subcycle, bool bCollideOnly);
+	void _LBM_collideSite_opt(int i, int j, int k, int id, eType type_local, double *f_local, double rho_local, const double *u_local, CollideBatch *batch = nullptr);
+	void _LBM_stream_opt(int i, int j, int k, int id, eType type_local, int subcycle, double *f_local);
+	void _LBM_streamLink_opt(int i, int j, int k, int id, eType type_local, int v, eLinkType link_type, int subcycle, double *f_local);
+	eLinkType _LBM_getLinkType(eType type_local, eType src_type_local, eLinkType first = eBFLLink);
+	double _LBM_coalesce_opt(int i, int j, int k, int id, int v);
+	double _LBM_explode_opt(int id, int v, int src_x, int src_y, int src_z);
+	void _LBM_collide_opt(int id, double *f_local, double rho_local, const double *u_local);
+#ifdef L_COLLIDE_BATCH
+	void _LBM_collideBatch_opt(CollideBatch &batch);
+#endif
+	void _LBM_macro_opt(int i, int j, int k, int id, eType type_local, double *f_local);
+	void _LBM_macro_opt(int i, int j, int k, int id, eType type_local, double *f_local, double &rho_local, double *u_local, bool bStore);
+	bool _LBM_isMacroStoreStep();
+	int _LBM_sweepLength();
+	double _LBM_vorticity(int i, int j, int k);
+	void _LBM_coalesceSubGrid(GridObj *sg, bool bPopulations);
+	GridObj* _LBM_detachSubGrid(int reg);
+	void _LBM_attachSubGrid(int reg, const double *edges, GridObj *oldGrid);
+	void _LBM_fillFromGrids(GridObj *oldGrid);
+	void _LBM_refreshSubGrids();
+	static void _LBM_advanceConcurrent(const std::vector<GridObj*> &grids, int subcycle, const std::vector<GridObj*> &overlap, int overlapSubcycle);
+	void _LBM_timeAverage_opt(int id, double rho_local, const double *u_local);
+	void _LBM_forceGrid_opt(int id, const double *u_local);
 	double _LBM_equilibrium_opt(int id, int v);
-	bool _LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k, int src_x, int src_y, int src_z);
-	bool _LBM_applySpecReflect_opt(int i, int j, int k, int id, int v);
-	void _LBM_regularised_opt(int i, int j, int k, int id, eType type, int subcycle);
-	void _LBM_kbcCollide_opt(int id);
+	void _LBM_equilibria_opt(double rho_local, const double *u_local, double *feq_local);
+	bool _LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k, int src_x, int src_y, int src_z, double *f_local);
+	bool _LBM_applySpecReflect_opt(int i, int j, int k, int id, int v, double *f_local);
+	void _LBM_regularised_opt(int i, int j, int k, int id, eType type, int subcycle, double *f_local);
+	void _LBM_kbcCollide_opt(int id, double *f_local);
 	void _LBM_resetForces();
-	double _LBM_smag(int id, double omega);
+	double _LBM_smag(double omega, const double *f_local, const double *feq_local);
+	int _LBM_inIdx_opt(int i, int j, int k, int id, int v);
+	void _LBM_storeStreamed_opt(int i, int j, int k, int id, double *f_local);
+	void _LBM_loadStreamed_opt(int i, int j, int k, int id, double *f_local);
+	void _LBM_storeCollided_opt(int i, int j, int k, int id, double *f_local);
 	void _LBM_updateInteriorLatticeSite(int i, int j, int k, int subcycle);
 	double _LBM_updateAndExtrapolate(int subcycle, IVector<double> &quantity,
 			std::vector<int> direction, int order, int i, int j, int k, int p = NULL, int max = 1);
 
 public :
 	void LBM_multi_opt(int subcycle = 0);
+	void LBM_multiBlocked_opt();
+	void LBM_multiConcurrent_opt();
+	void LBM_adaptRefinement();
 
 
 };
 
+// *****************************************************************************
+/// \brief	Flattened index of a population.
+///
+///			All population-sized arrays (f, fNew, feq, force_i) must be accessed
+///			through this method so that the memory layout can be selected at
+///			compile time. By default the populations of a site are contiguous
+///			(array-of-structures). If L_SOA_LAYOUT is defined, each lattice
+///			direction is stored as a contiguous plane over all sites
+///			(structure-of-arrays). On grids using sparse storage the site is
+///			first mapped to its position in the compacted arrays.
+///
+/// \param	id	flattened ijk index.
+/// \param	v	lattice direction.
+/// \return		index into the population array.
+inline int GridObj::LBM_popIdx(int id, int v) const
+{
+#ifdef L_SPARSE_STORAGE
+	if (bSparse) id = sparseIdx[id];
+#endif
+#ifdef L_SOA_LAYOUT
+	return id + v * numStoredSites;
+#else
+	return v + id * L_NUM_VELS;
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Flattened index of a population.
+///
+/// \param	i	x-index of site.
+/// \param	j	y-index of site.
+/// \param	k	z-index of site.
+/// \param	v	lattice direction.
+/// \return		index into the population array.
+inline int GridObj::LBM_popIdx(int i, int j, int k, int v) const
+{
+	return LBM_popIdx(k + j * K_lim + i * K_lim * M_lim, v);
+}
+
+// *****************************************************************************
+/// \brief	Whether the populations of a site are stored.
+///
+///			Inactive sites on a grid using sparse storage share a single scratch
+///			site so their populations have no meaning.
+///
+/// \param	i	x-index of site.
+/// \param	j	y-index of site.
+/// \param	k	z-index of site.
+/// \return		true if the site has its own storage.
+inline bool GridObj::LBM_isStored(int i, int j, int k) const
+{
+	return (!bSparse || sparseIdx[k + j * K_lim + i * K_lim * M_lim] < numStoredSites - 1);
+}
+
 #endif
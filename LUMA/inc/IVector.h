@@ -24,6 +24,7 @@
 #define IVECTOR_H
 
 #include "stdafx.h"
+#include "FirstTouchAllocator.h"
 
 /// \brief	Index-collapsing vector class.
 ///
@@ -31,8 +32,11 @@
 ///			has a overriden operator() to allow automatic flattening of indices 
 ///			before returning a reference of value at indexed location.
 ///			Needs to be able to accept different datatypes so templated.
+///			Storage comes from FirstTouchAllocator so large fields can be 
+///			left untouched until the grid places them on the NUMA nodes of 
+///			the threads that update them.
 template <typename GenTyp>
-class IVector :	public std::vector<GenTyp>		// Define IVector class which inherits from std::vector
+class IVector :	public std::vector<GenTyp, FirstTouchAllocator<GenTyp> >		// Define IVector class which inherits from std::vector
 {
 	
 public:
@@ -68,6 +72,24 @@ public:
 		}
 
 	}
+
+	using std::vector<GenTyp, FirstTouchAllocator<GenTyp> >::resize;
+
+	/// \brief	Resize, value-initialising any new elements.
+	///
+	/// \param size the desired size of vector
+	void resize(size_t size) {
+		std::vector<GenTyp, FirstTouchAllocator<GenTyp> >::resize(size, GenTyp());
+	}
+
+	/// \brief	Resize without writing any new elements.
+	///
+	///			New elements of arithmetic types are left uninitialised so their 
+	///			pages are not touched until they are first written.
+	/// \param size the desired size of vector
+	void resizeUninitialised(size_t size) {
+		std::vector<GenTyp, FirstTouchAllocator<GenTyp> >::resize(size);
+	}
 	
 
 
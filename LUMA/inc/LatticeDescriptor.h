@@ -0,0 +1,190 @@
+/*
+* --------------------------------------------------------------
+*
+* ------ Lattice Boltzmann @ The University of Manchester ------
+*
+* -------------------------- L-U-M-A ---------------------------
+*
+* Copyright 2018 The University of Manchester
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.*
+*/
+
+#ifndef LATTICE_DESCRIPTOR_H
+#define LATTICE_DESCRIPTOR_H
+
+// *****************************************************************************
+/// \brief	Compile-time description of a lattice velocity set.
+///
+///			Specialised for each supported DdQq model. As the velocities and 
+///			weights are constant expressions, direction loops with a fixed trip 
+///			count over them can be unrolled by the compiler and the zero 
+///			velocity components folded away.
+///
+/// \tparam	Dims	number of dimensions.
+/// \tparam	Vels	number of lattice velocities.
+template <int Dims, int Vels>
+struct LatticeDescriptor;
+
+/// \brief	D2Q9 lattice.
+template <>
+struct LatticeDescriptor<2, 9>
+{
+	static constexpr int dims = 2;				///< Number of dimensions
+	static constexpr int vels = 9;				///< Number of lattice velocities
+	static constexpr int c[vels][3] =			///< Lattice velocities
+	{
+		{ 1, 0, 0 },
+		{ -1, 0, 0 },
+		{ 0, 1, 0 },
+		{ 0, -1, 0 },
+		{ 1, 1, 0 },
+		{ -1, -1, 0 },
+		{ 1, -1, 0 },
+		{ -1, 1, 0 },
+		{ 0, 0, 0 }
+	};
+	static constexpr double w[vels] =			///< Quadrature weights
+	{
+		1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0,
+		1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0,
+		4.0 / 9.0
+	};
+};
+
+/// \brief	D3Q19 lattice.
+template <>
+struct LatticeDescriptor<3, 19>
+{
+	static constexpr int dims = 3;				///< Number of dimensions
+	static constexpr int vels = 19;				///< Number of lattice velocities
+	static constexpr int c[vels][3] =			///< Lattice velocities
+	{
+		{ 1, 0, 0 },
+		{ -1, 0, 0 },
+		{ 0, 1, 0 },
+		{ 0, -1, 0 },
+		{ 0, 0, 1 },
+		{ 0, 0, -1 },
+		{ 1, 1, 0 },
+		{ -1, -1, 0 },
+		{ 1, -1, 0 },
+		{ -1, 1, 0 },
+		{ 0, 1, 1 },
+		{ 0, -1, -1 },
+		{ 0, 1, -1 },
+		{ 0, -1, 1 },
+		{ 1, 0, 1 },
+		{ -1, 0, -1 },
+		{ -1, 0, 1 },
+		{ 1, 0, -1 },
+		{ 0, 0, 0 }
+	};
+	static constexpr double w[vels] =			///< Quadrature weights
+	{
+		1.0 / 18.0, 1.0 / 18.0, 1.0 / 18.0, 1.0 / 18.0, 1.0 / 18.0, 1.0 / 18.0,
+		1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0,
+		1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0,
+		1.0 / 3.0
+	};
+};
+
+/// \brief	D3Q27 lattice.
+template <>
+struct LatticeDescriptor<3, 27>
+{
+	static constexpr int dims = 3;				///< Number of dimensions
+	static constexpr int vels = 27;				///< Number of lattice velocities
+	static constexpr int c[vels][3] =			///< Lattice velocities
+	{
+		{ 1, 0, 0 },
+		{ -1, 0, 0 },
+		{ 0, 1, 0 },
+		{ 0, -1, 0 },
+		{ 0, 0, 1 },
+		{ 0, 0, -1 },
+		{ 0, 1, 1 },
+		{ 0, -1, -1 },
+		{ 0, 1, -1 },
+		{ 0, -1, 1 },
+		{ 1, 0, 1 },
+		{ -1, 0, -1 },
+		{ 1, 0, -1 },
+		{ -1, 0, 1 },
+		{ 1, 1, 0 },
+		{ -1, -1, 0 },
+		{ 1, -1, 0 },
+		{ -1, 1, 0 },
+		{ 1, 1, 1 },
+		{ -1, -1, -1 },
+		{ -1, -1, 1 },
+		{ 1, 1, -1 },
+		{ -1, 1, 1 },
+		{ 1, -1, -1 },
+		{ 1, -1, 1 },
+		{ -1, 1, -1 },
+		{ 0, 0, 0 }
+	};
+	static constexpr double w[vels] =			///< Quadrature weights
+	{
+		2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0,
+		1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0,
+		1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0,
+		1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0,
+		1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0,
+		8.0 / 27.0
+	};
+};
+
+/// \brief	Compile-time list of indices.
+template <int... Is>
+struct IndexList {};
+
+/// \brief	Builds the index list 0 ... N-1.
+template <int N, int... Is>
+struct MakeIndexList : MakeIndexList<N - 1, N - 1, Is...> {};
+
+/// \brief	Terminates the index list recursion.
+template <int... Is>
+struct MakeIndexList<0, Is...>
+{
+	typedef IndexList<Is...> type;
+};
+
+// *****************************************************************************
+/// \brief	Lattice velocities of a descriptor arranged by component.
+///
+///			Generated from the velocities of the descriptor so the two
+///			arrangements cannot disagree.
+///
+/// \tparam	Descriptor	lattice descriptor.
+/// \tparam	Indices		velocity indices of the descriptor.
+template <typename Descriptor, typename Indices = typename MakeIndexList<Descriptor::vels>::type>
+struct TransposedVelocities;
+
+/// \brief	Expands the velocity indices into one row per component.
+template <typename Descriptor, int... V>
+struct TransposedVelocities<Descriptor, IndexList<V...>>
+{
+	static constexpr int c[3][Descriptor::vels] =	///< Lattice velocities by component
+	{
+		{ Descriptor::c[V][0]... },
+		{ Descriptor::c[V][1]... },
+		{ Descriptor::c[V][2]... }
+	};
+};
+
+template <typename Descriptor, int... V>
+constexpr int TransposedVelocities<Descriptor, IndexList<V...>>::c[3][Descriptor::vels];
+
+#endif
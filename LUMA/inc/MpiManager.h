@@ -32,12 +32,12 @@ class IBBody;
 
 
 // Define the loop expressions required to inspect the overlap regions of a grid for ease of coding
-#define range_i_left	i = 0; i < GridUtils::downToLimit((int)pow(2, g->level + 1), N_lim); i++	///< For loop definition for left halo
-#define range_j_down	j = 0; j < GridUtils::downToLimit((int)pow(2, g->level + 1), M_lim); j++	///< For loop definition for bottom halo
-#define range_k_front	k = 0; k < GridUtils::downToLimit((int)pow(2, g->level + 1), K_lim); k++	///< For loop definition for front halo
-#define range_i_right	i = GridUtils::upToZero(N_lim - (int)pow(2, g->level + 1)); i < N_lim; i++	///< For loop definition for right halo
-#define range_j_up		j = GridUtils::upToZero(M_lim - (int)pow(2, g->level + 1)); j < M_lim; j++	///< For loop definition for top halo
-#define range_k_back	k = GridUtils::upToZero(K_lim - (int)pow(2, g->level + 1)); k < K_lim; k++	///< For loop definition for back halo
+#define range_i_left	i = 0; i < GridUtils::downToLimit(L_HALO_WIDTH * (int)pow(2, g->level + 1), N_lim); i++	///< For loop definition for left halo
+#define range_j_down	j = 0; j < GridUtils::downToLimit(L_HALO_WIDTH * (int)pow(2, g->level + 1), M_lim); j++	///< For loop definition for bottom halo
+#define range_k_front	k = 0; k < GridUtils::downToLimit(L_HALO_WIDTH * (int)pow(2, g->level + 1), K_lim); k++	///< For loop definition for front halo
+#define range_i_right	i = GridUtils::upToZero(N_lim - L_HALO_WIDTH * (int)pow(2, g->level + 1)); i < N_lim; i++	///< For loop definition for right halo
+#define range_j_up		j = GridUtils::upToZero(M_lim - L_HALO_WIDTH * (int)pow(2, g->level + 1)); j < M_lim; j++	///< For loop definition for top halo
+#define range_k_back	k = GridUtils::upToZero(K_lim - L_HALO_WIDTH * (int)pow(2, g->level + 1)); k < K_lim; k++	///< For loop definition for back halo
 
 /// \brief	MPI Manager class.
 ///
@@ -81,12 +81,14 @@ class MpiManager
 		// Copy constructor
 		LoadImbalanceData(LoadImbalanceData& other)
 			: loadImbalance(other.loadImbalance), uniImbalance(other.uniImbalance),
-			heaviestBlock(other.heaviestBlock), heaviestOps(other.heaviestOps)
+			heaviestBlock(other.heaviestBlock), heaviestOps(other.heaviestOps),
+			criticalPath(other.criticalPath)
 		{ };
 
 		double loadImbalance;		///< Imbalance assocaited with smart decomposition.
 		double uniImbalance;		///< Imbalance assocaited with uniform decomposition.
-		size_t heaviestOps;			///< Number of operations on heaviest rank.
+		double heaviestOps;			///< Predicted cost of a coarse time step on heaviest rank.
+		double criticalPath;		///< Predicted cost of a coarse time step when each level waits for its slowest rank.
 		std::vector<unsigned int> heaviestBlock;	///< MPI indices of the heaviest block.
 	};
 
@@ -133,6 +135,12 @@ public :
 	// Communicators for IBM-level specific communications
 	std::vector<MPI_Comm> lev_comm;
 
+	// Shared memory halo exchange
+	MPI_Comm node_comm;						///< Communicator of the ranks which share memory with this one
+	MPI_Group node_group;					///< Group of node_comm
+	int neighbour_node_rank[L_MPI_DIRS];	///< Rank in node_comm of the neighbour in each direction (MPI_UNDEFINED if off-node)
+	std::vector<MPI_Win> halo_wins;			///< Shared memory windows of every level and region
+
 	// Commonly used properties of the rank / topology
 	int my_rank;				///< Rank number
 	int num_ranks;				///< Total number of ranks in MPI Cartesian topology
@@ -166,22 +174,44 @@ public :
 	
 
 	// Buffer data
-	std::vector< std::vector<double>> f_buffer_send;	///< Array of resizeable outgoing buffers used for data transfer
-	std::vector< std::vector<double>> f_buffer_recv;	///< Array of resizeable incoming buffers used for data transfer
+	std::vector<int> halo_vels[L_MPI_DIRS];			///< Lattice directions of the populations sent in each direction
 	MPI_Status recv_stat;					///< Status structure for Receive return information
 	MPI_Request send_requests[L_MPI_DIRS];	///< Array of request structures for handles to posted ISends
 	MPI_Status send_stat[L_MPI_DIRS];		///< Array of statuses for each ISend
+	clock_t comm_secs;						///< Clock ticks spent posting the communication in progress
+	eHaloExchange halo_exchange;			///< Backend used for the halo messages not exchanged through shared memory
 
 	/// \struct BufferSizeStruct
-	/// \brief	Structure storing buffers sizes in each direction for particular grid.
+	/// \brief	Structure storing buffers sizes and sites in each direction for particular grid.
+	///
+	///			Also owns the message buffers of the grid and the persistent
+	///			requests bound to them, which are set up once by 
+	///			mpi_buffer_size() and restarted at every exchange. Messages
+	///			exchanged with on-node neighbours through shared memory have no
+	///			buffer or request of their own. The same messages may instead 
+	///			be exchanged by a neighbourhood collective.
 	struct BufferSizeStruct
 	{
 		int size[L_MPI_DIRS];	///< Buffer sizes for each direction
+		std::vector<int> sites[L_MPI_DIRS];	///< Flattened list of (i,j,k) indices of the sites of each direction in buffer order
+		std::vector<popType> buffer;	///< Message buffer holding the messages of each direction in turn
+		popType *data[L_MPI_DIRS];	///< Start of the message of each direction (in its buffer or in shared memory)
+		MPI_Request requests[L_MPI_DIRS];	///< Persistent requests of the non-empty messages
+		int dirs[L_MPI_DIRS];	///< Direction of each persistent request
+		int count;				///< Number of persistent requests
+		std::vector<int> counts;	///< Size of the message of each persistent request
+		std::vector<int> displs;	///< Offset in the buffer of the message of each persistent request
+		MPI_Comm graph_comm;	///< Distributed graph communicator joining the ranks which hold the grid along the persistent requests
+		MPI_Request coll_request;	///< Request of the neighbourhood collective in progress (sender info only)
+		int shared_dirs[L_MPI_DIRS];	///< Directions exchanged through shared memory
+		int shared_count;		///< Number of directions exchanged through shared memory
+		MPI_Group shared_group;	///< Other ranks of node_comm taking part in the shared memory exchange
+		MPI_Win win;			///< Shared memory window of the grid
 		int level;				///< Grid level
 		int region;				///< Region number
 
 		BufferSizeStruct(int l, int r) 
-			: level(l), region(r){};
+			: count(0), graph_comm(MPI_COMM_NULL), shared_count(0), shared_group(MPI_GROUP_EMPTY), win(MPI_WIN_NULL), level(l), region(r){};
 	};
 	std::vector<BufferSizeStruct> buffer_send_info;	///< Vectors of buffer_info structures holding sender layer size info.
 	std::vector<BufferSizeStruct> buffer_recv_info;	///< Vectors of buffer_info structures holding receiver layer size info.
@@ -195,6 +225,9 @@ public :
 	std::vector<std::vector<SupportCommMarkerSideClass>> supportCommMarkerSide;		///< Marker-side marker-support comm
 	std::vector<std::vector<SupportCommSupportSideClass>> supportCommSupportSide;	///< Support-side marker-support comm
 
+	// Load model
+	std::vector<double> costTable;	///< Summed-area table per level of the calibrated cost of the L0 sites (empty unless a cost map was read)
+
 
 
 	/************** Member Methods **************/
@@ -217,25 +250,39 @@ public :
 	void mpi_SDComputeImbalance(LoadImbalanceData& load, SDData& solutionData, std::vector<int>& numCores);
 	bool mpi_SDCheckDelta(SDData& solutionData, double dh, std::vector<int>& numCores);
 	void mpi_SDCommunicateSolution(SDData& solutionData, double imbalance, double dh);
+	double mpi_SDGetBlockCost(double *bounds, int lev);				// Predicted cost of a time step of one level within a block
+	void mpi_SDReadCostMap();										// Read the cost map of an earlier profiling run
+	void mpi_profileLoad(GridManager* const grid_man);				// Fit the site costs to the kernel timings and write a cost map
 	void mpi_setSubGridDepth();										// Method to initialise the rankGrids variable
+	void mpi_rebuildGridInfo(GridManager* const grid_man);			// Rebuild buffer sizes and communicators after the hierarchy changes
 
 	// Helper functions
 	std::vector<int> mpi_mapRankLevelToWorld(int level);			// Map rank numbers from level communicator to world communcator
 	std::vector<int> mpi_mapRankWorldToLevel(int level);			// Map rank numbers from world communicator to level communicator
 
 	// Buffer methods
-	void mpi_buffer_pack(int dir, GridObj* const g);		// Pack the buffer ready for data transfer on the supplied grid in specified direction
-	void mpi_buffer_unpack(int dir, GridObj* const g);		// Unpack the buffer back to the grid given
+	void mpi_buffer_pack(int dir, GridObj* const g, const popType* const pop, BufferSizeStruct* const bufs);		// Pack the buffer ready for data transfer from the supplied populations of a grid in specified direction
+	void mpi_buffer_unpack(int dir, GridObj* const g, BufferSizeStruct* const bufr);	// Unpack the buffer back to the grid given
+	BufferSizeStruct* mpi_getBufferInfo(std::vector<BufferSizeStruct>& info, int lev, int reg);	// Find the buffer info of the grid of given level/region
 	void mpi_buffer_size();									// Set buffer size information for grids in hierarchy given and 
 															// set pointer to hierarchy for subsequent access
+	void mpi_buildHaloRequests();							// Allocate the buffers and persistent requests of every grid
+	void mpi_buildSharedHalo();								// Allocate the shared memory windows of every grid
+	void mpi_buildNeighbourGraphs();						// Create the distributed graph communicator of every grid
+	void mpi_freeHaloRequests();							// Free the persistent requests, graph communicators and shared memory windows of every grid
 	void mpi_buffer_size_send( GridObj* const g );			// Routine to find the size of the sending buffer on supplied grid
 	void mpi_buffer_size_recv( GridObj* const g );			// Routine to find the size of the receiving buffer on supplied grid
 
 	// IO
-	void mpi_writeout_buf(std::string filename, int dir);		// Write out the buffers of direction dir to file
+	void mpi_writeout_buf(std::string filename, int dir, BufferSizeStruct* const bufs, BufferSizeStruct* const bufr);	// Write out the buffers of direction dir to file
 
 	// Comms
 	void mpi_communicate( int level, int regnum );		// Wrapper routine for communication between grids of given level/region
+	void mpi_communicateStart( int level, int regnum, const popType* const pop );	// Pack and post the halo messages of the grid of given level/region from the supplied populations
+	void mpi_communicateFinish( int level, int regnum );	// Wait for and unpack the halo messages of the grid of given level/region
+	void mpi_haloPost(GridObj* const g, const popType* const pop, BufferSizeStruct* const bufs, BufferSizeStruct* const bufr);		// Pack and post the halo messages of a grid with the chosen backend
+	void mpi_haloComplete(GridObj* const g, BufferSizeStruct* const bufs, BufferSizeStruct* const bufr);	// Wait for and unpack the halo messages of a grid
+	void mpi_setHaloExchange(int argc, char* argv[]);	// Choose the halo exchange backend, timing both if asked
 	int mpi_getOpposite(int direction);					// Version of GridUtils::getOpposite for MPI_directions rather than lattice directions
 
 	// IBM
@@ -97,6 +97,7 @@ private:
 	double bbbForceOnObjectX = 0.0;			///< Instantaneous X-direction force on BB bodies in domain
 	double bbbForceOnObjectY = 0.0;			///< Instantaneous Y-direction force on BB bodies in domain
 	double bbbForceOnObjectZ = 0.0;			///< Instantaneous Z-direction force on BB bodies in domain
+	std::vector< std::vector<double> > threadMomexForces;	///< Thread-local momentum exchange forces (BB bodies then each BFL marker)
 	int bbbOnGridLevel = -1;				///< Grid level on which the BB body resides
 	int bbbOnGridReg = -1;					///< Grid region on which the BB body resides
 
@@ -176,8 +177,9 @@ public:
 	void addBouncebackObject(GeomPacked *geom, PCpts *_PCpts);				// Override method to add BBB from cloud reader.
 	void addBouncebackObject(GridObj *g, GeomPacked *geom, PCpts *_PCpts);	// Method to add a BBB from the cloud reader.
 	void computeLiftDrag(int i, int j, int k, GridObj *g);			// Compute force using Momentum Exchange for BBB on supplied grid.
-	void computeLiftDrag(int v, int id, GridObj *g, int markerID);	// Compute force using Momentum Exchange for BFL on supplied grid.
+	void computeLiftDrag(int v, int id, GridObj *g, int markerID, double f_new);	// Compute force using Momentum Exchange for BFL on supplied grid.
 	void resetMomexBodyForces(GridObj * grid);						// Reset the force stores for Momentum Exchange
+	void sumMomexBodyForces();										// Add the thread-local Momentum Exchange forces to the force stores
 
 	// IO methods //
 	void io_vtkBodyWriter(int tval);						// VTK body writer wrapper
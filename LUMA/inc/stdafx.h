@@ -201,6 +201,7 @@ inline void debugfcn(const std::string &msg, std::ofstream *logfile)
 
 // Include definitions, singletons and headers to be made available everywhere for convenience.
 #include "definitions.h"
+#include "LatticeDescriptor.h"
 #include "GridManager.h"
 #include <mpi.h>
 #include "MpiManager.h"
@@ -213,9 +214,10 @@ inline void debugfcn(const std::string &msg, std::ofstream *logfile)
 /****************************************************/
 
 // Global variable references
-extern const int c[3][L_NUM_VELS];				///< Lattice velocities
-extern const int c_opt[L_NUM_VELS][3];			///< Lattice velocities optimised arrangement
-extern const double w[L_NUM_VELS];				///< Quadrature weights
+typedef LatticeDescriptor<L_DIMS, L_NUM_VELS> Lattice;	///< Lattice velocity set in use
+static constexpr const int (&c)[3][L_NUM_VELS] = TransposedVelocities<Lattice>::c;	///< Lattice velocities
+static constexpr const int (&c_opt)[L_NUM_VELS][3] = Lattice::c;	///< Lattice velocities optimised arrangement
+static constexpr const double (&w)[L_NUM_VELS] = Lattice::w;		///< Quadrature weights
 extern const double cs;							///< Lattice sound speed
 
 // Debug stuff -- maybe I should put all these debug statements into some static
@@ -228,7 +230,7 @@ testout << "\nNEW TIME STEP" << std::endl; \
 for (size_t j = 1; j < M_lim - 1; j++) { \
 	for (size_t i = 0; i < N_lim; i++) { \
 		for (size_t v = 0; v < L_NUM_VELS; v++) { \
-			testout << force_i(i, j, 0, v, M_lim, K_lim, L_NUM_VELS) << "\t"; \
+			testout << force_i[LBM_popIdx(i, j, 0, v)] << "\t"; \
 		} \
 		testout << std::endl; \
 	} \
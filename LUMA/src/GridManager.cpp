@@ -89,6 +89,18 @@ GridManager::GridManager()
 			periodic_flags[eYDirection][idx] = false;
 			periodic_flags[eZDirection][idx] = false;
 
+#ifdef L_ADAPTIVE_REFINEMENT
+			// Empty slot for a region created at run time
+			if (cRefStartX[lev - 1][reg] < 0.0)
+			{
+				for (int d = 0; d < 6; ++d)
+					global_edges[d][idx] = -1.0;
+				for (int d = 0; d < 3; ++d)
+					global_size[d][idx] = 0;
+				continue;
+			}
+#endif
+
 			/* If using auto sub-grid generation, the padding from the definitions 
 			 * file will be used to define the grid edges. */
 #ifdef L_AUTO_SUBGRIDS
@@ -344,8 +356,8 @@ bool GridManager::createWritableDataStore(GridObj const * const targetGrid)
 		}
 		else
 		{
-			p_data->i_end = N_lim - 2;
-			p_data->i_start = 1;
+			p_data->i_end = N_lim - 1 - L_HALO_WIDTH;
+			p_data->i_start = L_HALO_WIDTH;
 		}
 
 		if (MpiManager::getInstance()->dimensions[eYDirection] == 1)
@@ -355,8 +367,8 @@ bool GridManager::createWritableDataStore(GridObj const * const targetGrid)
 		}
 		else
 		{
-			p_data->j_end = M_lim - 2;
-			p_data->j_start = 1;
+			p_data->j_end = M_lim - 1 - L_HALO_WIDTH;
+			p_data->j_start = L_HALO_WIDTH;
 		}
 #if (L_DIMS == 3)
 		if (MpiManager::getInstance()->dimensions[eZDirection] == 1)
@@ -366,8 +378,8 @@ bool GridManager::createWritableDataStore(GridObj const * const targetGrid)
 		}
 		else
 		{		
-			p_data->k_end = K_lim - 2;
-			p_data->k_start = 1;
+			p_data->k_end = K_lim - 1 - L_HALO_WIDTH;
+			p_data->k_start = L_HALO_WIDTH;
 		}
 #endif
 
@@ -50,7 +50,7 @@ GridObj::~GridObj(void)
 /// \param level always should be zero as top level grid.
 GridObj::GridObj(int level)
 	: t(0), level(level), region_number(0),
-	timeav_mpi_overhead(0.0), timeav_timestep(0.0),
+	timeav_mpi_overhead(0.0), timeav_timestep(0.0), step_secs(0.0),
 	refinement_ratio(1.0 / pow(2.0, static_cast<double>(level)))
 {
 	// Set limits of refinement to zero as top level
@@ -78,7 +78,7 @@ GridObj::GridObj(int level)
 GridObj::GridObj(int RegionNumber, GridObj& pGrid)
 	: t(0), level(pGrid.level + 1), region_number(RegionNumber),
 	parentGrid(&pGrid), refinement_ratio(1.0 / pow(2.0, static_cast<double>(pGrid.level + 1))),
-	timeav_mpi_overhead(0.0), timeav_timestep(0.0)
+	timeav_mpi_overhead(0.0), timeav_timestep(0.0), step_secs(0.0)
 {	
 	// Notify user that grid constructor has been called
 	L_INFO("Constructing Sub-Grid level " + std::to_string(level) +
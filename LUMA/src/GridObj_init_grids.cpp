@@ -25,6 +25,12 @@
 
 #include "../inc/stdafx.h"
 #include "../inc/GridObj.h"
+#ifdef L_ENABLE_OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -269,6 +275,70 @@ void GridObj::LBM_initGrid() {
 	L_ERROR("Cannot use regularised boundaries with D3Q27 because of the corner treatment. Exiting.", GridUtils::logfile);
 #endif
 
+	// Temporal blocking only handles the plain stream-collide step on a single grid
+#ifdef L_TEMPORAL_BLOCKING
+#if (L_NUM_LEVELS != 0 || defined L_IBM_ON || defined L_INPLACE_STREAMING || defined L_LD_OUT || defined L_REGULARISED_BOUNDARIES)
+	L_ERROR("Temporal blocking cannot be used with sub-grids, IBM, in-place streaming, lift and drag output or regularised boundaries. Exiting.", GridUtils::logfile);
+#endif
+
+	// The wavefront cannot pull across a periodic wrap in x which is not covered by a halo
+	int lims[3] = { N_lim, M_lim, K_lim };
+	bool bHalo[3] = { false, false, false };
+#ifdef L_BUILD_FOR_MPI
+	for (int d = 0; d < L_DIMS; ++d)
+		bHalo[d] = (mpim->dimensions[d] > 1);
+#endif
+	if (!bHalo[eXDirection] && (L_WALL_LEFT != eSolid || L_WALL_RIGHT != eSolid))
+		L_ERROR("Temporal blocking needs at least two MPI ranks in x unless both x-walls are solid. Exiting.", GridUtils::logfile);
+
+	// Sender layers must not overlap
+	for (int d = 0; d < L_DIMS; ++d)
+	{
+		if (bHalo[d] && lims[d] < 4 * L_HALO_WIDTH)
+			L_ERROR("Grid on this rank is too small for a halo of width " + std::to_string(L_HALO_WIDTH) + ". Exiting.", GridUtils::logfile);
+	}
+#endif
+
+	// Concurrent grids handle the plain stream-collide step only
+#if (defined L_CONCURRENT_GRIDS && (defined L_TEMPORAL_BLOCKING || defined L_IBM_ON || defined L_INPLACE_STREAMING || defined L_LD_OUT))
+	L_ERROR("Concurrent grids cannot be used with temporal blocking, IBM, in-place streaming or lift and drag output. Exiting.", GridUtils::logfile);
+#endif
+
+	// Halo sites only receive the populations streaming out of them so must not be advanced or read otherwise
+#if (defined L_MPI_CROSSING_POPS && (defined L_TEMPORAL_BLOCKING || defined L_ADAPTIVE_REFINEMENT))
+	L_ERROR("Sending only crossing populations cannot be used with temporal blocking or adaptive refinement. Exiting.", GridUtils::logfile);
+#endif
+
+	// Overlapping the halo exchange relies on streaming into a separate array
+#if (defined L_MPI_OVERLAP && defined L_INPLACE_STREAMING)
+	L_ERROR("Overlapping the MPI halo exchange cannot be used with in-place streaming. Exiting.", GridUtils::logfile);
+#endif
+
+	// Slip walls read the pre-stream value of the site which is not kept when streaming in place
+#ifdef L_INPLACE_STREAMING
+	if (L_WALL_LEFT == eSlip || L_WALL_RIGHT == eSlip || L_WALL_BOTTOM == eSlip || L_WALL_TOP == eSlip
+#if (L_DIMS == 3)
+		|| L_WALL_FRONT == eSlip || L_WALL_BACK == eSlip
+#endif
+		)
+		L_ERROR("Slip BCs cannot be used with in-place streaming. Exiting.", GridUtils::logfile);
+#endif
+
+	// Batched collisions only implement LBGK
+#if (defined L_COLLIDE_BATCH && defined L_USE_KBC_COLLISION)
+	L_ERROR("Batched collisions cannot be used with the KBC collision operator. Exiting.", GridUtils::logfile);
+#endif
+
+	// Adaptive refinement rebuilds single-level regions from the L0 solution
+#if (defined L_ADAPTIVE_REFINEMENT && (L_NUM_LEVELS != 1 || defined L_IBM_ON || defined L_SPARSE_STORAGE || defined L_RESTARTING))
+	L_ERROR("Adaptive refinement needs exactly one level of refinement and cannot be used with IBM, sparse storage or restarts. Exiting.", GridUtils::logfile);
+#endif
+
+	// Blocks are kept from the site labels and must align with the parent sites
+#if (defined L_BLOCK_REFINEMENT && (L_BLOCK_SIZE < 4 || L_BLOCK_SIZE % 2 != 0 || defined L_ADAPTIVE_REFINEMENT || defined L_IBM_ON))
+	L_ERROR("Block refinement needs an even block size of at least 4 and cannot be used with adaptive refinement or IBM. Exiting.", GridUtils::logfile);
+#endif
+
 	// Add boundary-specific labels
 	LBM_initBoundLab();
 
@@ -306,10 +376,17 @@ void GridObj::LBM_initGrid() {
 	uiuj_timeav.resize(N_lim * M_lim * K_lim * (3 * L_DIMS - 3), 0.0);
 
 
+	// Streaming connectivity (needed to address f)
+	_LBM_initStreamTables();
+	_LBM_initTiles();
+	numStoredSites = N_lim * M_lim * K_lim;
+
 	// Initialise L0 POPULATION matrices (f, feq)
 	f.resize(N_lim * M_lim * K_lim * L_NUM_VELS);
 	feq.resize(N_lim * M_lim * K_lim * L_NUM_VELS);
+#ifndef L_INPLACE_STREAMING
 	fNew.resize(N_lim * M_lim * K_lim * L_NUM_VELS);
+#endif
 
 
 	// Loop over grid
@@ -322,15 +399,17 @@ void GridObj::LBM_initGrid() {
 				for (int v = 0; v < L_NUM_VELS; v++)
 				{
 					// Initialise f to feq
-					f(i, j, k, v, M_lim, K_lim, L_NUM_VELS) = 
+					feq[LBM_popIdx(i, j, k, v)] = 
 						_LBM_equilibrium_opt(k + j * K_lim + i * M_lim * K_lim, v);
+					f[LBM_fIdx(i, j, k, v)] = feq[LBM_popIdx(i, j, k, v)];
 
 				}
 			}
 		}
 	}
-	feq = f; // Make feq = feq too
+#ifndef L_INPLACE_STREAMING
 	fNew = f;
+#endif
 
 
 #ifdef L_NU
@@ -495,11 +574,21 @@ void GridObj::LBM_initSubGrid (GridObj& pGrid)
 #endif
 
 
+	// Streaming connectivity (needed to address f)
+	_LBM_initStreamTables();
+	_LBM_initTiles();
+	numStoredSites = N_lim * M_lim * K_lim;
+
+	// Coupling with the parent (needed by the multi-grid kernels)
+	_LBM_initCouplingMaps(pGrid);
+
 	// Generate POPULATION MATRICES for lower levels
 	// Resize
 	f.resize(N_lim * M_lim * K_lim * L_NUM_VELS);
 	feq.resize(N_lim * M_lim * K_lim * L_NUM_VELS);
+#ifndef L_INPLACE_STREAMING
 	fNew.resize(N_lim * M_lim * K_lim * L_NUM_VELS);
+#endif
 
 
 	// Loop over grid
@@ -513,15 +602,17 @@ void GridObj::LBM_initSubGrid (GridObj& pGrid)
 				{
 					
 					// Initialise f to feq
-					f(i, j, k, v, M_lim, K_lim, L_NUM_VELS) = 
+					feq[LBM_popIdx(i, j, k, v)] = 
 						_LBM_equilibrium_opt(k + j * K_lim + i * M_lim * K_lim, v);
+					f[LBM_fIdx(i, j, k, v)] = feq[LBM_popIdx(i, j, k, v)];
 
 				}
 			}
 		}
 	}
-	feq = f; // Set feq to feq
+#ifndef L_INPLACE_STREAMING
 	fNew = f;
+#endif
 
 	// Compute relaxation time from coarser level assume refinement by factor of 2
 	omega = 1.0 / ( ( (1.0 / pGrid.omega - 0.5) * 2.0) + 0.5);
@@ -1232,7 +1323,7 @@ void GridObj::_LBM_initGetInletProfileFromFile()
 	// Indicate to log
 	*GridUtils::logfile << "Loading inlet profile..." << std::endl;
 
-	IVector<double> xbuffer, ybuffer, zbuffer, uxbuffer, uybuffer, uzbuffer;
+	std::vector<double> xbuffer, ybuffer, zbuffer, uxbuffer, uybuffer, uzbuffer;
 	GridUtils::readVelocityFromFile("./input/inlet_profile.in", xbuffer, ybuffer, zbuffer, uxbuffer, uybuffer, uzbuffer);
 
 	// Loop over site positions (for left hand inlet, y positions)
@@ -1349,6 +1440,796 @@ void GridObj::_LBM_initSetInletProfile()
 #endif
 }
 
+// *****************************************************************************
+/// \brief	Method to build the streaming connectivity of the grid.
+///
+///			Streaming pulls from the upstream site (i - c_x, j - c_y, k - c_z).
+///			For interior sites this is a fixed offset in the flattened index
+///			which is stored per direction. Sites on the edge of the grid pull
+///			across the periodic wrap so the wrapped upstream index along each
+///			axis is tabulated instead. This removes all integer division from
+///			the streaming step.
+void GridObj::_LBM_initStreamTables()
+{
+	// Resize tables
+	streamSrcX.resize(N_lim * L_NUM_VELS);
+	streamSrcY.resize(M_lim * L_NUM_VELS);
+	streamSrcZ.resize(K_lim * L_NUM_VELS);
+
+	for (int v = 0; v < L_NUM_VELS; ++v)
+	{
+		// Interior offset
+		streamOffset[v] = -(c_opt[v][2] + c_opt[v][1] * K_lim + c_opt[v][0] * K_lim * M_lim);
+
+		// Wrapped upstream indices
+		for (int i = 0; i < N_lim; ++i)
+			streamSrcX[i + v * N_lim] = (i - c_opt[v][0] + N_lim) % N_lim;
+		for (int j = 0; j < M_lim; ++j)
+			streamSrcY[j + v * M_lim] = (j - c_opt[v][1] + M_lim) % M_lim;
+		for (int k = 0; k < K_lim; ++k)
+			streamSrcZ[k + v * K_lim] = (k - c_opt[v][2] + K_lim) % K_lim;
+	}
+}
+
+// *****************************************************************************
+/// \brief	Method to choose the cache blocking of the site loop.
+///
+///			Pulling a site reads populations from the neighbouring x-planes. If 
+///			a y-z plane is too big for the cache those planes are evicted before 
+///			they are reused, so the loop is split into tiles whose three planes 
+///			fit in half of the L2 cache. Tile extents set in the definitions 
+///			take precedence. Unless set, the x extent gives each OpenMP thread 
+///			one slab so that the static schedule over the tiles hands each 
+///			thread the sites it first touched.
+void GridObj::_LBM_initTiles()
+{
+	// Cache size
+	long l2Bytes = 256 * 1024;
+#if defined __linux__ && defined _SC_LEVEL2_CACHE_SIZE
+	if (sysconf(_SC_LEVEL2_CACHE_SIZE) > 0) l2Bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+
+	// Sites of a plane which fit (populations and moments of three planes)
+	const int siteBytes = static_cast<int>(L_NUM_VELS * sizeof(popType) * 2 + (L_DIMS + 1) * sizeof(double));
+	const int planeSites = std::max(1, static_cast<int>(l2Bytes / (2 * 3 * siteBytes)));
+
+	// Keep z whole where possible to give long unit-stride inner loops
+	int threads = 1;
+#ifdef L_ENABLE_OPENMP
+	threads = omp_get_max_threads();
+#endif
+	tileSize[eXDirection] = (L_TILE_I > 0) ? L_TILE_I : (N_lim + threads - 1) / threads;
+	tileSize[eZDirection] = (L_TILE_K > 0) ? L_TILE_K : std::min(K_lim, std::max(1, planeSites / 8));
+	tileSize[eYDirection] = (L_TILE_J > 0) ? L_TILE_J : std::min(M_lim, std::max(1, planeSites / tileSize[eZDirection]));
+	for (int d = 0; d < 3; ++d) tileSize[d] = std::max(1, tileSize[d]);
+
+	// Tiles in i-major order
+	tiles.clear();
+	for (int i = 0; i < N_lim; i += tileSize[eXDirection])
+	{
+		for (int j = 0; j < M_lim; j += tileSize[eYDirection])
+		{
+			for (int k = 0; k < K_lim; k += tileSize[eZDirection])
+			{
+				tiles.push_back(i);
+				tiles.push_back(std::min(i + tileSize[eXDirection], N_lim));
+				tiles.push_back(j);
+				tiles.push_back(std::min(j + tileSize[eYDirection], M_lim));
+				tiles.push_back(k);
+				tiles.push_back(std::min(k + tileSize[eZDirection], K_lim));
+			}
+		}
+	}
+
+	L_INFO("Grid " + std::to_string(level) + " Region " + std::to_string(region_number) +
+		": " + std::to_string(tiles.size() / 6) + " tiles of " + std::to_string(tileSize[eXDirection]) +
+		" x " + std::to_string(tileSize[eYDirection]) + " x " + std::to_string(tileSize[eZDirection]) + " sites.", GridUtils::logfile);
+
+	_LBM_initOverlap();
+}
+
+// *****************************************************************************
+/// \brief	Method to split the site loop for overlapping the halo exchange.
+///
+///			Each tile is cut into boxes which either lie wholly on the sender 
+///			and receiver layers of the MPI halo or wholly off them. The halo 
+///			boxes are streamed first so the exchange can be posted while the 
+///			interior boxes are streamed. Active sparse sites are reordered the
+///			same way. Must be called whenever the tiles or sparse sites change.
+void GridObj::_LBM_initOverlap()
+{
+#if (defined L_BUILD_FOR_MPI && defined L_MPI_OVERLAP)
+	// Halo flag of each index in each direction
+	std::vector<bool> bHalo[3];
+	const std::vector<double> *pos[3] = { &XPos, &YPos, &ZPos };
+	const int lims[3] = { N_lim, M_lim, K_lim };
+	for (int d = 0; d < 3; ++d)
+	{
+		bHalo[d].assign(lims[d], false);
+		if (d >= L_DIMS) continue;
+		eCartMinMax edges[2] = { static_cast<eCartMinMax>(2 * d), static_cast<eCartMinMax>(2 * d + 1) };
+		for (int n = 0; n < lims[d]; ++n)
+		{
+			for (eCartMinMax e : edges)
+			{
+				if (GridUtils::isOnSenderLayer((*pos[d])[n], e) || GridUtils::isOnRecvLayer((*pos[d])[n], e))
+					bHalo[d][n] = true;
+			}
+		}
+	}
+
+	// Cut each tile into runs of the same flag in each direction
+	shellTiles.clear();
+	innerTiles.clear();
+	for (size_t n = 0; n < tiles.size(); n += 6)
+	{
+		std::vector<int> runs[3];
+		for (int d = 0; d < 3; ++d)
+		{
+			for (int a = tiles[n + 2 * d]; a < tiles[n + 2 * d + 1];)
+			{
+				int b = a + 1;
+				while (b < tiles[n + 2 * d + 1] && bHalo[d][b] == bHalo[d][a]) ++b;
+				runs[d].push_back(a);
+				runs[d].push_back(b);
+				a = b;
+			}
+		}
+
+		for (size_t ri = 0; ri < runs[0].size(); ri += 2)
+		{
+			for (size_t rj = 0; rj < runs[1].size(); rj += 2)
+			{
+				for (size_t rk = 0; rk < runs[2].size(); rk += 2)
+				{
+					bool bShell = bHalo[0][runs[0][ri]] || bHalo[1][runs[1][rj]] || bHalo[2][runs[2][rk]];
+					std::vector<int> &list = bShell ? shellTiles : innerTiles;
+					list.insert(list.end(), 
+					{
+						runs[0][ri], runs[0][ri + 1], runs[1][rj], runs[1][rj + 1], runs[2][rk], runs[2][rk + 1]
+					});
+				}
+			}
+		}
+	}
+
+	// Halo sites first in the sparse list
+	if (bSparse)
+	{
+		std::vector<int> shell, inner;
+		for (size_t n = 0; n < sparseSites.size(); n += 3)
+		{
+			bool bShell = bHalo[0][sparseSites[n]] || bHalo[1][sparseSites[n + 1]] || bHalo[2][sparseSites[n + 2]];
+			std::vector<int> &list = bShell ? shell : inner;
+			list.insert(list.end(), sparseSites.begin() + n, sparseSites.begin() + n + 3);
+		}
+		sparseShellEnd = static_cast<int>(shell.size());
+		sparseSites.swap(shell);
+		sparseSites.insert(sparseSites.end(), inner.begin(), inner.end());
+	}
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Method to build the index maps between this grid and its parent.
+///
+///			The coupling is separable so each direction gets its own table of
+///			enclosing parent indices and of first child indices. The parent 
+///			also records which of its sub-grids covers each site so the 
+///			multi-grid kernels need not search the regions on every call, and 
+///			which of its tiles hold such sites. Must be called once this grid 
+///			is in the parent's sub-grid list and its local size is known.
+///
+/// \param	pGrid	reference to parent grid.
+void GridObj::_LBM_initCouplingMaps(GridObj& pGrid)
+{
+	// Enclosing parent site of each site on this grid
+	coarseIdxX.resize(N_lim);
+	coarseIdxY.resize(M_lim);
+	coarseIdxZ.resize(K_lim);
+	for (int i = 0; i < N_lim; ++i) coarseIdxX[i] = i / 2 + CoarseLimsX[eMinimum];
+	for (int j = 0; j < M_lim; ++j) coarseIdxY[j] = j / 2 + CoarseLimsY[eMinimum];
+#if (L_DIMS == 3)
+	for (int k = 0; k < K_lim; ++k) coarseIdxZ[k] = k / 2 + CoarseLimsZ[eMinimum];
+#else
+	coarseIdxZ[0] = 0;
+#endif
+
+	// First child of each parent site (only meaningful inside the coarse limits)
+	fineIdxX.resize(pGrid.N_lim);
+	fineIdxY.resize(pGrid.M_lim);
+	fineIdxZ.resize(pGrid.K_lim);
+	for (int i = 0; i < pGrid.N_lim; ++i) fineIdxX[i] = 2 * (i - CoarseLimsX[eMinimum]);
+	for (int j = 0; j < pGrid.M_lim; ++j) fineIdxY[j] = 2 * (j - CoarseLimsY[eMinimum]);
+#if (L_DIMS == 3)
+	for (int k = 0; k < pGrid.K_lim; ++k) fineIdxZ[k] = 2 * (k - CoarseLimsZ[eMinimum]);
+#else
+	fineIdxZ[0] = 0;
+#endif
+
+	// Mark the parent sites covered by this grid
+	if (pGrid.subGridIdx.empty())
+		pGrid.subGridIdx.assign(pGrid.N_lim * pGrid.M_lim * pGrid.K_lim, -1);
+	int sg = static_cast<int>(std::find(pGrid.subGrid.begin(), pGrid.subGrid.end(), this) - pGrid.subGrid.begin());
+	for (int i = coarseIdxX[0]; i <= coarseIdxX[N_lim - 1]; ++i)
+	{
+		for (int j = coarseIdxY[0]; j <= coarseIdxY[M_lim - 1]; ++j)
+		{
+			for (int k = coarseIdxZ[0]; k <= coarseIdxZ[K_lim - 1]; ++k)
+			{
+				pGrid.subGridIdx[k + j * pGrid.K_lim + i * pGrid.K_lim * pGrid.M_lim] = sg;
+			}
+		}
+	}
+
+	// Flag the parent tiles which cannot be advanced independently of the sub-grids
+	pGrid.tileCoupled.assign(pGrid.tiles.size() / 6, false);
+	for (size_t n = 0; n < pGrid.tiles.size(); n += 6)
+	{
+		for (int i = pGrid.tiles[n]; i < pGrid.tiles[n + 1]; ++i)
+		{
+			for (int j = pGrid.tiles[n + 2]; j < pGrid.tiles[n + 3]; ++j)
+			{
+				for (int k = pGrid.tiles[n + 4]; k < pGrid.tiles[n + 5]; ++k)
+				{
+					if (pGrid.subGridIdx[k + j * pGrid.K_lim + i * pGrid.K_lim * pGrid.M_lim] >= 0)
+						pGrid.tileCoupled[n / 6] = true;
+				}
+			}
+		}
+	}
+}
+
+// *****************************************************************************
+/// \brief	Method to build the boundary link lists of the grid and its sub-grids.
+///
+///			Must be called once all site labels are final. Any streaming link
+///			which is not a regular pull from the source site is recorded so that
+///			the streaming kernel can pull every link regularly and then only 
+///			revisit these links. The links of each site are stored contiguously 
+///			and grouped by treatment.
+void GridObj::LBM_initBoundaryLinks()
+{
+	// Sub-grids first
+	for (GridObj *sg : subGrid)
+		sg->LBM_initBoundaryLinks();
+
+	// Reset lists
+	linkStart.assign(N_lim * M_lim * K_lim + 1, 0);
+	linkDir.clear();
+	linkType.clear();
+
+	for (int i = 0; i < N_lim; ++i)
+	{
+		for (int j = 0; j < M_lim; ++j)
+		{
+			for (int k = 0; k < K_lim; ++k)
+			{
+				int id = k + j * K_lim + i * K_lim * M_lim;
+
+				// Add links of this site grouped by treatment
+				for (int lt = eBFLLink; lt < eRegularLink; ++lt)
+				{
+					for (int v = 0; v < L_NUM_VELS; ++v)
+					{
+						int src_id = streamSrcZ[k + v * K_lim] +
+							streamSrcY[j + v * M_lim] * K_lim +
+							streamSrcX[i + v * N_lim] * K_lim * M_lim;
+
+						if (_LBM_getLinkType(LatTyp[id], LatTyp[src_id]) == lt)
+						{
+#ifdef L_INPLACE_STREAMING
+							// Pre-stream values of the BFL stencil are not kept when streaming in place
+							if (lt == eBFLLink)
+								L_ERROR("BFL BCs cannot be used with in-place streaming. Exiting.", GridUtils::logfile);
+#endif
+							linkDir.push_back(v);
+							linkType.push_back(static_cast<eLinkType>(lt));
+						}
+					}
+				}
+				linkStart[id + 1] = static_cast<int>(linkDir.size());
+			}
+		}
+	}
+
+	L_INFO("Grid " + std::to_string(level) + " Region " + std::to_string(region_number) +
+		": " + std::to_string(linkDir.size()) + " boundary links.", GridUtils::logfile);
+}
+
+// *****************************************************************************
+/// \brief	Moves a dense population array into sparse storage.
+///
+///			Must be called once the sparse indices have been built. Empty arrays 
+///			are left untouched.
+///
+///	\param	pop	population array to compact.
+template <typename T>
+void GridObj::_LBM_compactPopulations(IVector<T> &pop)
+{
+#ifdef L_SPARSE_STORAGE
+	if (pop.empty()) return;
+
+	int num_sites = N_lim * M_lim * K_lim;
+	IVector<T> compact(numStoredSites * L_NUM_VELS, 0);
+	for (size_t n = 0; n < sparseSites.size(); n += 3)
+	{
+		int id = sparseSites[n + 2] + sparseSites[n + 1] * K_lim + sparseSites[n] * K_lim * M_lim;
+		for (int v = 0; v < L_NUM_VELS; ++v)
+		{
+			// Index in dense arrays
+#ifdef L_SOA_LAYOUT
+			int dense_idx = id + v * num_sites;
+#else
+			int dense_idx = v + id * L_NUM_VELS;
+#endif
+			compact[LBM_popIdx(id, v)] = pop[dense_idx];
+		}
+	}
+	pop.swap(compact);
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Method to switch the grid and its sub-grids to sparse storage.
+///
+///			Must be called once all site labels are final. A site is inactive if
+///			it and all its lattice neighbours are solid or refined as its
+///			populations are then never used by the update. If the fraction of
+///			inactive sites on a grid is at least L_SPARSE_MIN_INACTIVE the
+///			population arrays of that grid are compacted so that only active
+///			sites are stored and the kernel only visits active sites. Inactive
+///			sites share a single scratch site at the end of the arrays so that
+///			any site may still be addressed.
+void GridObj::LBM_initSparseStorage()
+{
+	// Sub-grids first
+	for (GridObj *sg : subGrid)
+		sg->LBM_initSparseStorage();
+
+#ifdef L_SPARSE_STORAGE
+	int num_sites = N_lim * M_lim * K_lim;
+	int num_active = 0;
+
+	// Label active sites in order
+	sparseIdx.resize(num_sites);
+	sparseSites.clear();
+	for (int i = 0; i < N_lim; ++i)
+	{
+		for (int j = 0; j < M_lim; ++j)
+		{
+			for (int k = 0; k < K_lim; ++k)
+			{
+				// Check site and its neighbours (rest direction is the site itself)
+				bool bActive = false;
+				for (int v = 0; v < L_NUM_VELS && !bActive; ++v)
+				{
+					int nbr_id = streamSrcZ[k + v * K_lim] + 
+						streamSrcY[j + v * M_lim] * K_lim + 
+						streamSrcX[i + v * N_lim] * K_lim * M_lim;
+					bActive = (LatTyp[nbr_id] != eSolid && LatTyp[nbr_id] != eRefined);
+				}
+
+				int id = k + j * K_lim + i * K_lim * M_lim;
+				if (bActive)
+				{
+					sparseIdx[id] = num_active++;
+					sparseSites.push_back(i);
+					sparseSites.push_back(j);
+					sparseSites.push_back(k);
+				}
+				else sparseIdx[id] = -1;
+			}
+		}
+	}
+
+	// Keep dense storage if not worthwhile
+	double inactive_fraction = 1.0 - static_cast<double>(num_active) / num_sites;
+	if (inactive_fraction < L_SPARSE_MIN_INACTIVE)
+	{
+		std::vector<int>().swap(sparseIdx);
+		std::vector<int>().swap(sparseSites);
+		L_INFO("Grid " + std::to_string(level) + " Region " + std::to_string(region_number) + 
+			": " + std::to_string(inactive_fraction * 100.0) + "% inactive sites so using dense storage.", GridUtils::logfile);
+		return;
+	}
+
+	// Inactive sites share the scratch site
+	for (int &idx : sparseIdx)
+	{
+		if (idx < 0) idx = num_active;
+	}
+	bSparse = true;
+	numStoredSites = num_active + 1;
+	_LBM_initOverlap();
+
+	// Compact population arrays (fNew and force_i may not be allocated)
+	_LBM_compactPopulations(f);
+	_LBM_compactPopulations(feq);
+	_LBM_compactPopulations(fNew);
+	_LBM_compactPopulations(force_i);
+
+	L_INFO("Grid " + std::to_string(level) + " Region " + std::to_string(region_number) + 
+		": " + std::to_string(inactive_fraction * 100.0) + "% inactive sites so using sparse storage.", GridUtils::logfile);
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Method to place the fields of the grid and its sub-grids.
+///
+///			Each field is moved to fresh memory which is first touched by the 
+///			OpenMP threads in the order and static schedule the kernel visits 
+///			the sites, so the pages of each site end up on the NUMA node of the
+///			thread which updates it. Must be called once the tiles and sparse 
+///			storage are final.
+void GridObj::LBM_initFirstTouch()
+{
+	// Sub-grids first
+	for (GridObj *sg : subGrid)
+		sg->LBM_initFirstTouch();
+
+#ifdef L_ENABLE_OPENMP
+	// Populations (fNew and force_i may not be allocated)
+	_LBM_firstTouch(f, L_NUM_VELS, true);
+	_LBM_firstTouch(fNew, L_NUM_VELS, true);
+	_LBM_firstTouch(feq, L_NUM_VELS, true);
+	_LBM_firstTouch(force_i, L_NUM_VELS, true);
+
+	// Macroscopic quantities
+	_LBM_firstTouch(rho, 1, false);
+	_LBM_firstTouch(u, L_DIMS, false);
+	_LBM_firstTouch(u_n, L_DIMS, false);
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Moves a field to memory first touched by the kernel site loop.
+///
+///			The values of the sites the kernel visits are copied by the thread
+///			which visits them. Any other values, such as those of dropped 
+///			refinement blocks or of the sparse scratch site, are then copied 
+///			serially. Empty fields are left untouched.
+///
+///	\param	field			field to move.
+///	\param	width			number of values per site.
+///	\param	bPopulations	true if the field is indexed like the populations.
+template <typename T>
+void GridObj::_LBM_firstTouch(IVector<T> &field, int width, bool bPopulations)
+{
+	if (field.empty()) return;
+
+	IVector<T> placed;
+	placed.resizeUninitialised(field.size());
+	std::vector<char> bCopied(field.size(), 0);
+
+	// Copy the values of a site
+	auto copySite = [&](int i, int j, int k)
+	{
+		int id = k + j * K_lim + i * K_lim * M_lim;
+		for (int n = 0; n < width; ++n)
+		{
+			int idx = bPopulations ? LBM_popIdx(id, n) : id * width + n;
+			placed[idx] = field[idx];
+			bCopied[idx] = 1;
+		}
+	};
+
+	// Same passes as the kernel
+#if (defined L_BUILD_FOR_MPI && defined L_MPI_OVERLAP && !defined L_IBM_ON)
+	const std::vector<int> *tileLists[2] = { &shellTiles, &innerTiles };
+	int sparseRanges[3] = { 0, sparseShellEnd, static_cast<int>(sparseSites.size()) };
+	const int numPasses = 2;
+#else
+	const std::vector<int> *tileLists[1] = { &tiles };
+	int sparseRanges[2] = { 0, static_cast<int>(sparseSites.size()) };
+	const int numPasses = 1;
+#endif
+
+	for (int pass = 0; pass < numPasses; ++pass)
+	{
+		if (bSparse)
+		{
+#ifdef L_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+			for (int n = sparseRanges[pass]; n < sparseRanges[pass + 1]; n += 3)
+				copySite(sparseSites[n], sparseSites[n + 1], sparseSites[n + 2]);
+			continue;
+		}
+
+		const std::vector<int> &tileList = *tileLists[pass];
+#ifdef L_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+		for (int n = 0; n < static_cast<int>(tileList.size()); n += 6)
+		{
+			for (int i = tileList[n]; i < tileList[n + 1]; ++i)
+			{
+				for (int j = tileList[n + 2]; j < tileList[n + 3]; ++j)
+				{
+					for (int k = tileList[n + 4]; k < tileList[n + 5]; ++k)
+						copySite(i, j, k);
+				}
+			}
+		}
+	}
+
+	// Values the kernel does not visit
+	for (size_t idx = 0; idx < field.size(); ++idx)
+	{
+		if (!bCopied[idx]) placed[idx] = field[idx];
+	}
+	field.swap(placed);
+}
+
+// *****************************************************************************
+/// \brief	Method to trim the refined regions to the blocks which need them.
+///
+///			Called on L0 once all bodies are labelled. Each region is cut into
+///			blocks of L_BLOCK_SIZE sites of its own grid numbered from the 
+///			region origin so that all ranks agree on them. A block is kept if 
+///			it or a neighbouring block holds a wall, body, boundary or finer 
+///			region site. The sites of the other blocks are handed back to the 
+///			parent so refined regions follow the geometry rather than filling 
+///			whole boxes. Finer levels are trimmed first so their coverage is 
+///			final before their parent is trimmed. Must be called by all 
+///			processes. The blocks are only known once the grids are built so 
+///			the MPI decomposition balances whole regions unless it reads a 
+///			cost map profiled with L_MPI_PROFILE_LOAD, which only counts the 
+///			sites of kept blocks.
+void GridObj::LBM_initRefinementBlocks()
+{
+#ifdef L_BLOCK_REFINEMENT
+	GridManager *gm = GridManager::getInstance();
+
+	for (int lev = L_NUM_LEVELS; lev > 0; --lev)
+	{
+		for (int reg = 0; reg < L_NUM_REGIONS; ++reg)
+		{
+			// Blocks of the whole region
+			int gm_idx = lev + reg * L_NUM_LEVELS;
+			int numBlocks[3] = { 1, 1, 1 };
+			for (int d = 0; d < L_DIMS; ++d)
+				numBlocks[d] = (gm->global_size[d][gm_idx] + L_BLOCK_SIZE - 1) / L_BLOCK_SIZE;
+			int totalBlocks = numBlocks[0] * numBlocks[1] * numBlocks[2];
+			if (totalBlocks == 0) continue;
+
+			// Flag blocks holding sites which are not plain fluid
+			std::vector<int> flagged(totalBlocks, 0);
+			GridObj *g = nullptr;
+			GridUtils::getGrid(this, lev, reg, g);
+			if (g)
+			{
+				for (int i = 0; i < g->N_lim; ++i)
+				{
+					for (int j = 0; j < g->M_lim; ++j)
+					{
+						for (int k = 0; k < g->K_lim; ++k)
+						{
+							eType type = g->LatTyp[k + j * g->K_lim + i * g->K_lim * g->M_lim];
+							if (type != eFluid && type != eTransitionToCoarser)
+								flagged[g->_LBM_getBlock(g->XPos[i], g->YPos[j], g->ZPos[k], numBlocks)] = 1;
+						}
+					}
+				}
+			}
+#ifdef L_BUILD_FOR_MPI
+			MPI_Allreduce(MPI_IN_PLACE, &flagged[0], totalBlocks, MPI_INT, MPI_MAX, MpiManager::getInstance()->world_comm);
+#endif
+
+			// Keep the flagged blocks and their neighbours
+			std::vector<bool> kept(totalBlocks, false);
+			int numKept = 0;
+			for (int bi = 0; bi < numBlocks[0]; ++bi)
+			{
+				for (int bj = 0; bj < numBlocks[1]; ++bj)
+				{
+					for (int bk = 0; bk < numBlocks[2]; ++bk)
+					{
+						bool bKeep = false;
+						for (int ni = std::max(bi - 1, 0); ni <= std::min(bi + 1, numBlocks[0] - 1); ++ni)
+						{
+							for (int nj = std::max(bj - 1, 0); nj <= std::min(bj + 1, numBlocks[1] - 1); ++nj)
+							{
+								for (int nk = std::max(bk - 1, 0); nk <= std::min(bk + 1, numBlocks[2] - 1); ++nk)
+									bKeep = bKeep || flagged[nk + nj * numBlocks[2] + ni * numBlocks[2] * numBlocks[1]];
+							}
+						}
+						kept[bk + bj * numBlocks[2] + bi * numBlocks[2] * numBlocks[1]] = bKeep;
+						if (bKeep) ++numKept;
+					}
+				}
+			}
+
+			if (g) g->_LBM_applyRefinementBlocks(kept, numBlocks);
+
+			L_INFO("Grid " + std::to_string(lev) + " Region " + std::to_string(reg) + ": " + 
+				std::to_string(numKept) + " of " + std::to_string(totalBlocks) + " refinement blocks kept.", GridUtils::logfile);
+		}
+	}
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Method to get the refinement block holding a position.
+///
+///			Blocks are numbered from the minimum edges of the region so the
+///			same position gives the same block on every rank. Positions off 
+///			the region belong to the nearest block.
+///
+/// \param	x			x-position.
+/// \param	y			y-position.
+/// \param	z			z-position.
+/// \param	numBlocks	number of blocks of the region in each direction.
+/// \return				flattened block index.
+int GridObj::_LBM_getBlock(double x, double y, double z, const int *numBlocks)
+{
+	double pos[3] = { x, y, z };
+	int b[3] = { 0, 0, 0 };
+	for (int d = 0; d < L_DIMS; ++d)
+		b[d] = _LBM_getBlock(pos[d], static_cast<eCartesianDirection>(d), numBlocks[d]);
+	return b[2] + b[1] * numBlocks[2] + b[0] * numBlocks[2] * numBlocks[1];
+}
+
+// *****************************************************************************
+/// \brief	Method to get the refinement block holding a position in one direction.
+///
+/// \param	xyz			position in the given direction.
+/// \param	dir			direction.
+/// \param	numBlocks	number of blocks of the region in the given direction.
+/// \return				block index in the given direction.
+int GridObj::_LBM_getBlock(double xyz, eCartesianDirection dir, int numBlocks)
+{
+	GridManager *gm = GridManager::getInstance();
+	int gm_idx = level + region_number * L_NUM_LEVELS;
+	int b = static_cast<int>(std::floor((xyz - gm->global_edges[2 * dir][gm_idx]) / (L_BLOCK_SIZE * dh)));
+	return std::min(std::max(b, 0), numBlocks - 1);
+}
+
+// *****************************************************************************
+/// \brief	Method to hand the sites of dropped blocks back to the parent.
+///
+///			Sites of dropped blocks are labelled as refined on this grid so 
+///			they are skipped, not communicated and not stored by sparse 
+///			storage. The parent sites they cover become fluid again and the 
+///			parent sites of kept blocks next to them join the transition 
+///			layer as at the edges of the region. The site loop of this grid 
+///			is then restricted to the kept blocks, visited in Morton order.
+///
+/// \param	kept		flag for each block of the region indicating it is kept.
+/// \param	numBlocks	number of blocks of the region in each direction.
+void GridObj::_LBM_applyRefinementBlocks(const std::vector<bool> &kept, const int *numBlocks)
+{
+	GridManager *gm = GridManager::getInstance();
+	int gm_idx = level + region_number * L_NUM_LEVELS;
+	double *edges[6];
+	for (int d = 0; d < 6; ++d) edges[d] = &gm->global_edges[d][gm_idx];
+
+	// Sites of dropped blocks
+	for (int i = 0; i < N_lim; ++i)
+	{
+		for (int j = 0; j < M_lim; ++j)
+		{
+			for (int k = 0; k < K_lim; ++k)
+			{
+				if (!kept[_LBM_getBlock(XPos[i], YPos[j], ZPos[k], numBlocks)])
+					LatTyp[k + j * K_lim + i * K_lim * M_lim] = eRefined;
+			}
+		}
+	}
+
+	// Parent sites covered by this grid
+	GridObj *p = parentGrid;
+	for (int i = coarseIdxX.front(); i <= coarseIdxX.back(); ++i)
+	{
+		for (int j = coarseIdxY.front(); j <= coarseIdxY.back(); ++j)
+		{
+			for (int k = coarseIdxZ.front(); k <= coarseIdxZ.back(); ++k)
+			{
+				eType &type = p->LatTyp[k + j * p->K_lim + i * p->K_lim * p->M_lim];
+				if (type != eRefined && type != eTransitionToFiner) continue;
+
+				if (!kept[_LBM_getBlock(p->XPos[i], p->YPos[j], p->ZPos[k], numBlocks)])
+				{
+					type = eFluid;
+					continue;
+				}
+				if (type == eTransitionToFiner) continue;
+
+				// Look for a neighbour within the region which was dropped
+				bool bEdge = false;
+				for (int di = -1; di <= 1 && !bEdge; ++di)
+				{
+					for (int dj = -1; dj <= 1 && !bEdge; ++dj)
+					{
+#if (L_DIMS == 3)
+						for (int dk = -1; dk <= 1 && !bEdge; ++dk)
+#else
+						int dk = 0;
+#endif
+						{
+							double pos[3] = { p->XPos[i] + di * p->dh, p->YPos[j] + dj * p->dh, p->ZPos[k] + dk * p->dh };
+							bool bInside = true;
+							for (int d = 0; d < L_DIMS; ++d)
+								bInside = bInside && pos[d] > *edges[2 * d] && pos[d] < *edges[2 * d + 1];
+							bEdge = bInside && !kept[_LBM_getBlock(pos[0], pos[1], pos[2], numBlocks)];
+						}
+					}
+				}
+				if (!bEdge) continue;
+
+				// Both sides of the new transition layer
+				type = eTransitionToFiner;
+				for (int ci = fineIdxX[i]; ci <= std::min(fineIdxX[i] + 1, N_lim - 1); ++ci)
+				{
+					for (int cj = fineIdxY[j]; cj <= std::min(fineIdxY[j] + 1, M_lim - 1); ++cj)
+					{
+						for (int ck = fineIdxZ[k]; ck <= std::min(fineIdxZ[k] + 1, K_lim - 1); ++ck)
+						{
+							LatTyp[ck + cj * K_lim + ci * K_lim * M_lim] = eTransitionToCoarser;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// Runs of consecutive sites in the same block along each direction
+	const std::vector<double> *pos[3] = { &XPos, &YPos, &ZPos };
+	int lims[3] = { N_lim, M_lim, K_lim };
+	std::vector<int> runs[3];	// (start, end, block) of each run
+	for (int d = 0; d < 3; ++d)
+	{
+		for (int n = 0; n < lims[d]; ++n)
+		{
+			int b = (d < L_DIMS) ? _LBM_getBlock((*pos[d])[n], static_cast<eCartesianDirection>(d), numBlocks[d]) : 0;
+			if (!runs[d].empty() && runs[d].back() == b && runs[d][runs[d].size() - 2] == n)
+			{
+				++runs[d][runs[d].size() - 2];
+			}
+			else
+			{
+				runs[d].push_back(n);
+				runs[d].push_back(n + 1);
+				runs[d].push_back(b);
+			}
+		}
+	}
+
+	// Tiles of the kept blocks in Morton order
+	std::vector<std::pair<unsigned long long, std::vector<int>>> order;
+	for (size_t ri = 0; ri < runs[0].size(); ri += 3)
+	{
+		for (size_t rj = 0; rj < runs[1].size(); rj += 3)
+		{
+			for (size_t rk = 0; rk < runs[2].size(); rk += 3)
+			{
+				int bi = runs[0][ri + 2], bj = runs[1][rj + 2], bk = runs[2][rk + 2];
+				if (!kept[bk + bj * numBlocks[2] + bi * numBlocks[2] * numBlocks[1]]) continue;
+				order.push_back(std::make_pair(GridUtils::getMortonKey(bi, bj, bk), std::vector<int>
+				{
+					runs[0][ri], runs[0][ri + 1], runs[1][rj], runs[1][rj + 1], runs[2][rk], runs[2][rk + 1]
+				}));
+			}
+		}
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[](const std::pair<unsigned long long, std::vector<int>> &a, const std::pair<unsigned long long, std::vector<int>> &b) { return a.first < b.first; });
+	tiles.clear();
+	for (auto &o : order)
+		tiles.insert(tiles.end(), o.second.begin(), o.second.end());
+	_LBM_initOverlap();
+
+	// Sub-grids of this grid are coupled through the new tiles
+	if (!subGrid.empty())
+	{
+		subGridIdx.assign(N_lim * M_lim * K_lim, -1);
+		tileCoupled.assign(tiles.size() / 6, false);
+		for (GridObj *sg : subGrid)
+			sg->_LBM_initCouplingMaps(*this);
+	}
+}
+
 // *****************************************************************************
 /// \brief	Used to preserve the precedence of BCs during labelling.
 ///
@@ -0,0 +1,522 @@
+/*
+* --------------------------------------------------------------
+*
+* ------ Lattice Boltzmann @ The University of Manchester ------
+*
+* -------------------------- L-U-M-A ---------------------------
+*
+* Copyright 2018 The University of Manchester
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.*
+*/
+
+/* This file holds the code which adapts the refined regions to the flow at
+run time.
+*/
+
+#include "../inc/stdafx.h"
+#include "../inc/GridObj.h"
+#include "../inc/ObjectManager.h"
+#include <limits>
+
+// *****************************************************************************
+/// \brief	Adapt the L1 regions to the flow.
+///
+///			Called on the top-level grid. L0 sites whose vorticity exceeds
+///			L_AMR_THRESHOLD of the peak are flagged and each is given to the
+///			nearest region. A flagged site far from every region seeds a new
+///			region if an empty slot is available. Each region is then resized
+///			to the padded bounding box of its sites, regions left without
+///			sites are removed and regions which would touch are merged. The
+///			boxes are reduced over all ranks so every rank takes the same
+///			decisions. Regions which change are rebuilt and the grid
+///			infrastructure is refreshed.
+void GridObj::LBM_adaptRefinement()
+{
+	GridManager *gm = GridManager::getInstance();
+	if (ObjectManager::getInstance()->bbbOnGridLevel > 0)
+		L_ERROR("Adaptive refinement needs bodies to be placed on L0. Exiting.", GridUtils::logfile);
+
+	// Bring the fine solution up to the sites it covers
+	for (GridObj *sg : subGrid)
+		_LBM_coalesceSubGrid(sg, false);
+
+	// Sites owned by this rank which have neighbours on both sides
+	int lo[3] = { 1, 1, 0 };
+	int hi[3] = { N_lim - 1, M_lim - 1, 1 };
+#if (L_DIMS == 3)
+	lo[eZDirection] = 1;
+	hi[eZDirection] = K_lim - 1;
+#endif
+#ifdef L_BUILD_FOR_MPI
+	MpiManager *mpim = MpiManager::getInstance();
+	int lims[3] = { N_lim, M_lim, K_lim };
+	for (int d = 0; d < L_DIMS; ++d)
+	{
+		if (mpim->dimensions[d] > 1)
+		{
+			lo[d] = L_HALO_WIDTH;
+			hi[d] = lims[d] - L_HALO_WIDTH;
+		}
+	}
+#endif
+
+	// Refinement indicator
+	std::vector<double> vort(N_lim * M_lim * K_lim, 0.0);
+	double vortMax = 0.0;
+	for (int i = lo[eXDirection]; i < hi[eXDirection]; ++i)
+	{
+		for (int j = lo[eYDirection]; j < hi[eYDirection]; ++j)
+		{
+			for (int k = lo[eZDirection]; k < hi[eZDirection]; ++k)
+			{
+				int id = k + j * K_lim + i * K_lim * M_lim;
+				if (LatTyp[id] == eSolid) continue;
+				vort[id] = _LBM_vorticity(i, j, k);
+				vortMax = std::max(vortMax, vort[id]);
+			}
+		}
+	}
+#ifdef L_BUILD_FOR_MPI
+	MPI_Allreduce(MPI_IN_PLACE, &vortMax, 1, MPI_DOUBLE, MPI_MAX, mpim->world_comm);
+#endif
+	if (vortMax < L_SMALL_NUMBER) return;
+
+	// Current regions
+	bool bActive[L_NUM_REGIONS];
+	bool bFree = false;
+	for (int r = 0; r < L_NUM_REGIONS; ++r)
+	{
+		int gm_idx = 1 + r * L_NUM_LEVELS;
+		bActive[r] = (gm->global_edges[eXMax][gm_idx] > gm->global_edges[eXMin][gm_idx]);
+		if (!bActive[r]) bFree = true;
+	}
+
+	/* Extent of the flagged sites given to each region with the minimum edges
+	 * negated so a single maximum reduction gives the boxes. The last row
+	 * collects the sites which are far from every region. */
+	std::vector<double> ext(6 * (L_NUM_REGIONS + 1), -std::numeric_limits<double>::max());
+	for (int i = lo[eXDirection]; i < hi[eXDirection]; ++i)
+	{
+		for (int j = lo[eYDirection]; j < hi[eYDirection]; ++j)
+		{
+			for (int k = lo[eZDirection]; k < hi[eZDirection]; ++k)
+			{
+				if (vort[k + j * K_lim + i * K_lim * M_lim] <= L_AMR_THRESHOLD * vortMax) continue;
+				double pos[3] = { XPos[i], YPos[j], ZPos[k] };
+
+				// Nearest region
+				int best = L_NUM_REGIONS;
+				double bestDist = std::numeric_limits<double>::max();
+				for (int r = 0; r < L_NUM_REGIONS; ++r)
+				{
+					if (!bActive[r]) continue;
+					double dist = 0.0;
+					for (int d = 0; d < L_DIMS; ++d)
+					{
+						double edgeMin = gm->global_edges[2 * d][1 + r * L_NUM_LEVELS];
+						double edgeMax = gm->global_edges[2 * d + 1][1 + r * L_NUM_LEVELS];
+						dist += SQ(std::max(0.0, std::max(edgeMin - pos[d], pos[d] - edgeMax)));
+					}
+					if (dist < bestDist)
+					{
+						best = r;
+						bestDist = dist;
+					}
+				}
+				if (bFree && bestDist > SQ(L_AMR_PADDING * dh)) best = L_NUM_REGIONS;
+
+				for (int d = 0; d < L_DIMS; ++d)
+				{
+					ext[6 * best + 2 * d] = std::max(ext[6 * best + 2 * d], -(pos[d] - dh / 2.0));
+					ext[6 * best + 2 * d + 1] = std::max(ext[6 * best + 2 * d + 1], pos[d] + dh / 2.0);
+				}
+			}
+		}
+	}
+#ifdef L_BUILD_FOR_MPI
+	MPI_Allreduce(MPI_IN_PLACE, &ext[0], static_cast<int>(ext.size()), MPI_DOUBLE, MPI_MAX, mpim->world_comm);
+#endif
+
+	// Padded boxes snapped to the L0 cell edges and kept off the domain edges
+	double edges[L_NUM_REGIONS][6];
+	bool bNew[L_NUM_REGIONS];
+	int seed = L_NUM_REGIONS;
+	for (int r = 0; r < L_NUM_REGIONS; ++r)
+	{
+		if (!bActive[r] && seed == L_NUM_REGIONS && ext[6 * L_NUM_REGIONS + 1] > -ext[6 * L_NUM_REGIONS]) seed = r;
+	}
+	for (int r = 0; r < L_NUM_REGIONS; ++r)
+	{
+		int row = (r == seed) ? L_NUM_REGIONS : r;
+		bNew[r] = (bActive[r] || r == seed) && ext[6 * row + 1] > -ext[6 * row];
+		if (!bNew[r]) continue;
+
+		for (int d = 0; d < 6; ++d)
+			edges[r][d] = gm->global_edges[d][1 + r * L_NUM_LEVELS];
+		for (int d = 0; d < L_DIMS; ++d)
+		{
+			edges[r][2 * d] = std::max(std::round(-ext[6 * row + 2 * d] / dh) * dh - L_AMR_PADDING * dh,
+				gm->global_edges[2 * d][0] + dh);
+			edges[r][2 * d + 1] = std::min(std::round(ext[6 * row + 2 * d + 1] / dh) * dh + L_AMR_PADDING * dh,
+				gm->global_edges[2 * d + 1][0] - dh);
+		}
+	}
+
+	// Merge regions which would touch
+	bool bMerged = true;
+	while (bMerged)
+	{
+		bMerged = false;
+		for (int a = 0; a < L_NUM_REGIONS; ++a)
+		{
+			for (int b = a + 1; b < L_NUM_REGIONS; ++b)
+			{
+				if (!bNew[a] || !bNew[b]) continue;
+				bool bTouch = true;
+				for (int d = 0; d < L_DIMS; ++d)
+				{
+					if (edges[a][2 * d] > edges[b][2 * d + 1] + dh || edges[b][2 * d] > edges[a][2 * d + 1] + dh)
+						bTouch = false;
+				}
+				if (!bTouch) continue;
+
+				for (int d = 0; d < L_DIMS; ++d)
+				{
+					edges[a][2 * d] = std::min(edges[a][2 * d], edges[b][2 * d]);
+					edges[a][2 * d + 1] = std::max(edges[a][2 * d + 1], edges[b][2 * d + 1]);
+				}
+				bNew[b] = false;
+				bMerged = true;
+			}
+		}
+	}
+
+	// Find the regions which change
+	bool bMoved[L_NUM_REGIONS];
+	bool bChanged = false;
+	for (int r = 0; r < L_NUM_REGIONS; ++r)
+	{
+		bMoved[r] = (bActive[r] != bNew[r]);
+		for (int d = 0; d < 2 * L_DIMS && bNew[r] && !bMoved[r]; ++d)
+			bMoved[r] = (std::fabs(edges[r][d] - gm->global_edges[d][1 + r * L_NUM_LEVELS]) > L_SMALL_NUMBER);
+		if (!bMoved[r]) continue;
+
+		std::string msg = "Adaptive refinement at t = " + std::to_string(t) + ": Region " + std::to_string(r);
+		if (bNew[r])
+		{
+			msg += " now spans";
+			for (int d = 0; d < 2 * L_DIMS; ++d) msg += " " + std::to_string(edges[r][d]);
+		}
+		else
+		{
+			msg += " removed";
+		}
+		L_INFO(msg, GridUtils::logfile);
+		bChanged = true;
+	}
+
+	/* Hand back the sites of every old grid before building any new one so
+	 * that merged regions are built on up-to-date sites and labels. */
+	GridObj *oldGrids[L_NUM_REGIONS] = { nullptr };
+	for (int r = 0; r < L_NUM_REGIONS; ++r)
+	{
+		if (bMoved[r]) oldGrids[r] = _LBM_detachSubGrid(r);
+	}
+	for (int r = 0; r < L_NUM_REGIONS; ++r)
+	{
+		if (!bMoved[r]) continue;
+		_LBM_attachSubGrid(r, bNew[r] ? edges[r] : nullptr, oldGrids[r]);
+		delete oldGrids[r];
+	}
+
+	if (bChanged) _LBM_refreshSubGrids();
+}
+
+// *****************************************************************************
+/// \brief	Magnitude of the vorticity at a site.
+///
+///			Uses central differences so the site must have neighbours on both
+///			sides in every direction.
+///
+/// \param	i	x-index of site.
+/// \param	j	y-index of site.
+/// \param	k	z-index of site.
+/// \return		vorticity magnitude in lattice units.
+double GridObj::_LBM_vorticity(int i, int j, int k)
+{
+	// Velocity gradient (grad[a][b] = du_a / dx_b)
+	const int stride[3] = { K_lim * M_lim, K_lim, 1 };
+	int id = k + j * K_lim + i * K_lim * M_lim;
+	double grad[L_DIMS][L_DIMS];
+	for (int a = 0; a < L_DIMS; ++a)
+	{
+		for (int b = 0; b < L_DIMS; ++b)
+			grad[a][b] = 0.5 * (u[a + (id + stride[b]) * L_DIMS] - u[a + (id - stride[b]) * L_DIMS]);
+	}
+
+#if (L_DIMS == 3)
+	return sqrt(SQ(grad[2][1] - grad[1][2]) + SQ(grad[0][2] - grad[2][0]) + SQ(grad[1][0] - grad[0][1]));
+#else
+	return fabs(grad[1][0] - grad[0][1]);
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Coalesce a sub-grid onto the sites of this grid which it covers.
+///
+///			Each covered site takes the average of its children as in the
+///			coalesce operation of the kernel.
+///
+/// \param	sg				pointer to the sub-grid.
+/// \param	bPopulations	flag to indicate the populations are coalesced as
+///							well as the macroscopic quantities.
+void GridObj::_LBM_coalesceSubGrid(GridObj *sg, bool bPopulations)
+{
+#if (L_DIMS == 3)
+	const double nChildren = 8.0;
+	const int kk_lim = 2;
+#else
+	const double nChildren = 4.0;
+	const int kk_lim = 1;
+#endif
+
+	for (int i = sg->coarseIdxX.front(); i <= sg->coarseIdxX.back(); ++i)
+	{
+		for (int j = sg->coarseIdxY.front(); j <= sg->coarseIdxY.back(); ++j)
+		{
+			for (int k = sg->coarseIdxZ.front(); k <= sg->coarseIdxZ.back(); ++k)
+			{
+				int id = k + j * K_lim + i * K_lim * M_lim;
+
+				// Sum over the children
+				double rho_sum = 0.0;
+				double u_sum[L_DIMS] = { 0.0 };
+				double f_sum[L_NUM_VELS] = { 0.0 };
+				for (int ii = 0; ii < 2; ++ii)
+				{
+					for (int jj = 0; jj < 2; ++jj)
+					{
+						for (int kk = 0; kk < kk_lim; ++kk)
+						{
+							int ci = sg->fineIdxX[i] + ii;
+							int cj = sg->fineIdxY[j] + jj;
+							int ck = sg->fineIdxZ[k] + kk;
+							int cid = ck + cj * sg->K_lim + ci * sg->K_lim * sg->M_lim;
+
+							rho_sum += sg->rho[cid];
+							for (int d = 0; d < L_DIMS; ++d)
+								u_sum[d] += sg->u[d + cid * L_DIMS];
+							if (bPopulations)
+							{
+								for (int v = 0; v < L_NUM_VELS; ++v)
+									f_sum[v] += sg->f[sg->LBM_fIdx(ci, cj, ck, v)];
+							}
+						}
+					}
+				}
+
+				// Write averages
+				rho[id] = rho_sum / nChildren;
+				for (int d = 0; d < L_DIMS; ++d)
+					u[d + id * L_DIMS] = u_sum[d] / nChildren;
+				if (bPopulations)
+				{
+					for (int v = 0; v < L_NUM_VELS; ++v)
+						f[LBM_fIdx(i, j, k, v)] = static_cast<popType>(f_sum[v] / nChildren);
+				}
+			}
+		}
+	}
+}
+
+// *****************************************************************************
+/// \brief	Detach the sub-grid of a region.
+///
+///			The grid is removed from the sub-grid list and coalesced onto the
+///			sites it covers, whose labels are reset. The coupling maps, 
+///			boundary links and MPI data must be refreshed afterwards.
+///
+/// \param	reg		region number.
+/// \return			pointer to the detached grid (nullptr if not on this rank).
+GridObj* GridObj::_LBM_detachSubGrid(int reg)
+{
+	GridObj *oldGrid = nullptr;
+	for (size_t n = 0; n < subGrid.size(); ++n)
+	{
+		if (subGrid[n]->region_number == reg)
+		{
+			oldGrid = subGrid[n];
+			subGrid.erase(subGrid.begin() + n);
+			break;
+		}
+	}
+	if (!oldGrid) return nullptr;
+
+	// Hand back the covered sites
+	_LBM_coalesceSubGrid(oldGrid, true);
+	for (int i = oldGrid->coarseIdxX.front(); i <= oldGrid->coarseIdxX.back(); ++i)
+	{
+		for (int j = oldGrid->coarseIdxY.front(); j <= oldGrid->coarseIdxY.back(); ++j)
+		{
+			for (int k = oldGrid->coarseIdxZ.front(); k <= oldGrid->coarseIdxZ.back(); ++k)
+			{
+				int id = k + j * K_lim + i * K_lim * M_lim;
+				if (LatTyp[id] == eRefined || LatTyp[id] == eTransitionToFiner)
+					LatTyp[id] = eFluid;
+			}
+		}
+	}
+
+	return oldGrid;
+}
+
+// *****************************************************************************
+/// \brief	Build the sub-grid of a region with new edges.
+///
+///			The grid is only built if it meets this rank. It is filled from 
+///			the old grid of the region where they overlap and from this grid 
+///			elsewhere. The coupling maps, boundary links and MPI data must be 
+///			refreshed afterwards.
+///
+/// \param	reg		region number.
+/// \param	edges	new edges of the region (eCartMinMax order) or nullptr to leave it empty.
+/// \param	oldGrid	pointer to the previous grid of the region (may be nullptr).
+void GridObj::_LBM_attachSubGrid(int reg, const double *edges, GridObj *oldGrid)
+{
+	GridManager *gm = GridManager::getInstance();
+	int gm_idx = level + 1 + reg * L_NUM_LEVELS;
+
+	// Store the new extent (an empty region sits outside the domain)
+	for (int d = 0; d < L_DIMS; ++d)
+	{
+		gm->global_edges[2 * d][gm_idx] = edges ? edges[2 * d] : -1.0;
+		gm->global_edges[2 * d + 1][gm_idx] = edges ? edges[2 * d + 1] : -1.0;
+		gm->global_size[d][gm_idx] = edges ? static_cast<int>(2.0 * std::round((edges[2 * d + 1] - edges[2 * d]) / dh)) : 0;
+		gm->periodic_flags[d][gm_idx] = false;
+	}
+#if (L_DIMS == 2)
+	// 2D sub-grids span the parent in z
+	if (edges)
+	{
+		gm->global_edges[eZMin][gm_idx] = gm->global_edges[eZMin][0];
+		gm->global_edges[eZMax][gm_idx] = gm->global_edges[eZMax][0];
+		gm->global_size[eZDirection][gm_idx] = gm->global_size[eZDirection][0] * 2;
+		gm->periodic_flags[eZDirection][gm_idx] = true;
+	}
+#endif
+
+	if (!edges || !GridUtils::intersectsRefinedRegion(*this, reg)) return;
+
+	GridObj *g = new GridObj(reg, *this);
+	subGrid.push_back(g);
+	g->LBM_initSubGrid(*this);
+	g->t = 2 * t;
+	if (oldGrid) g->timeav_timestep = oldGrid->timeav_timestep;
+	g->_LBM_fillFromGrids(oldGrid);
+
+	// Keep the regions in order so every rank communicates in the same sequence
+	std::sort(subGrid.begin(), subGrid.end(),
+		[](const GridObj *a, const GridObj *b) { return a->region_number < b->region_number; });
+}
+
+// *****************************************************************************
+/// \brief	Fill a newly built sub-grid.
+///
+///			Sites which the old grid of the region also held are copied from
+///			it. The others are exploded from the parent by taking the values
+///			of the enclosing parent site.
+///
+/// \param	oldGrid		pointer to the previous grid of the region (may be nullptr).
+void GridObj::_LBM_fillFromGrids(GridObj *oldGrid)
+{
+	for (int i = 0; i < N_lim; ++i)
+	{
+		for (int j = 0; j < M_lim; ++j)
+		{
+			for (int k = 0; k < K_lim; ++k)
+			{
+				int id = k + j * K_lim + i * K_lim * M_lim;
+
+				// Enclosing parent site unless the old grid has this site
+				GridObj *src = parentGrid;
+				int si = coarseIdxX[i];
+				int sj = coarseIdxY[j];
+				int sk = coarseIdxZ[k];
+				if (oldGrid)
+				{
+					int oi = static_cast<int>(std::round((XPos[i] - oldGrid->XPos[0]) / dh));
+					int oj = static_cast<int>(std::round((YPos[j] - oldGrid->YPos[0]) / dh));
+					int ok = static_cast<int>(std::round((ZPos[k] - oldGrid->ZPos[0]) / dh));
+					if (oi >= 0 && oi < oldGrid->N_lim && oj >= 0 && oj < oldGrid->M_lim && ok >= 0 && ok < oldGrid->K_lim)
+					{
+						src = oldGrid;
+						si = oi;
+						sj = oj;
+						sk = ok;
+					}
+				}
+				int src_id = sk + sj * src->K_lim + si * src->K_lim * src->M_lim;
+
+				for (int v = 0; v < L_NUM_VELS; ++v)
+					f[LBM_fIdx(i, j, k, v)] = src->f[src->LBM_fIdx(si, sj, sk, v)];
+				for (int d = 0; d < L_DIMS; ++d)
+					u[d + id * L_DIMS] = src->u[d + src_id * L_DIMS];
+				rho[id] = src->rho[src_id];
+			}
+		}
+	}
+
+#ifndef L_INPLACE_STREAMING
+	fNew = f;
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Refresh the data which depends on the sub-grids of this grid.
+///
+///			Rebuilds the coupling maps, the boundary links, the MPI buffers
+///			and communicators and the writable data stores, and refreshes the
+///			halos of the sub-grids. Must be called by all processes.
+void GridObj::_LBM_refreshSubGrids()
+{
+	GridManager *gm = GridManager::getInstance();
+
+	// Coupling maps
+	subGridIdx.assign(N_lim * M_lim * K_lim, -1);
+	tileCoupled.assign(tiles.size() / 6, false);
+	for (GridObj *sg : subGrid)
+		sg->_LBM_initCouplingMaps(*this);
+
+	// Boundary links follow the new labels
+	LBM_initBoundaryLinks();
+
+	// Place the fields of the new sub-grids
+	for (GridObj *sg : subGrid)
+		sg->LBM_initFirstTouch();
+
+#ifdef L_BUILD_FOR_MPI
+	MpiManager *mpim = MpiManager::getInstance();
+	mpim->mpi_rebuildGridInfo(gm);
+	for (GridObj *sg : subGrid)
+		mpim->mpi_communicate(sg->level, sg->region_number);
+#else
+	gm->p_data.clear();
+	gm->createWritableDataStore(this);
+	for (GridObj *sg : subGrid)
+		gm->createWritableDataStore(sg);
+#endif
+
+	// Cell counts used for the performance output
+	gm->updateGlobalCellCount();
+}
@@ -164,8 +164,8 @@ void GridObj::io_textout(std::string output_tag) {
 					gridoutput << "\n";
 					for (size_t i = 0; i < N_lim; i++) {
 
-						// Output
-						gridoutput << f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) << "\t";
+						// Output (zero if site has no storage)
+						gridoutput << (LBM_isStored(i, j, k) ? f[LBM_fIdx(i, j, k, v)] : 0.0) << "\t";
 
 					}
 				}
@@ -187,8 +187,8 @@ void GridObj::io_textout(std::string output_tag) {
 					gridoutput << "\n";
 					for (size_t i = 0; i < N_lim; i++) {
 
-						// Output
-						gridoutput << feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) << "\t";
+						// Output (zero if site has no storage)
+						gridoutput << (LBM_isStored(i, j, k) ? feq[LBM_popIdx(i, j, k, v)] : 0.0) << "\t";
 
 					}
 				}
@@ -460,10 +460,11 @@ void GridObj::io_restart(eIOFlag IO_flag) {
 					file << rho(i, j, k, M_lim, K_lim) << "\t";
 
 					int id = k + j * K_lim + i * K_lim * M_lim;
-					// time - scaled fneq values
+					// time - scaled fneq values (sites without storage are written at equilibrium)
 					for (v = 0; v < L_NUM_VELS; v++) {
 						double f_eq = _LBM_equilibrium_opt(id, v);
-						double f_neq_restart = ((f(i, j, k, v, M_lim, K_lim, L_NUM_VELS) - f_eq) * omega) / (f_eq*dt);
+						double f_neq_restart = LBM_isStored(i, j, k) ? 
+							((f[LBM_fIdx(i, j, k, v)] - f_eq) * omega) / (f_eq*dt) : 0.0;
 						file << f_neq_restart << "\t";
 					}
 
@@ -564,8 +565,10 @@ void GridObj::io_restart(eIOFlag IO_flag) {
 				double f_temp;
 				double f_eq = _LBM_equilibrium_opt(id, v);
 				iss >> f_temp;
-				g->f(i, j, k, v, g->M_lim, g->K_lim, L_NUM_VELS) = f_eq*(1 + (g->dt*f_temp) / omega);
-				g->fNew(i, j, k, v, g->M_lim, g->K_lim, L_NUM_VELS) = g->f(i, j, k, v, g->M_lim, g->K_lim, L_NUM_VELS);
+				g->f[g->LBM_fIdx(i, j, k, v)] = f_eq*(1 + (g->dt*f_temp) / omega);
+#ifndef L_INPLACE_STREAMING
+				g->fNew[g->LBM_popIdx(i, j, k, v)] = g->f[g->LBM_popIdx(i, j, k, v)];
+#endif
 			}
 
 		}
@@ -752,13 +755,16 @@ void GridObj::io_lite(double tval, std::string TAG) {
 					litefile << std::to_string(0.0) << "\t";
 #endif
 
-					// Write out F and Feq
+					// Write out F and Feq (zero if site has no storage)
+					bool bStored = LBM_isStored(i, j, k);
 					for (v = 0; v < L_NUM_VELS; v++) {
-						litefile << f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) << "\t";
+						litefile << (bStored ? f[LBM_fIdx(i, j, k, v)] : 0.0) << "\t";
 					}
+#ifndef L_INPLACE_STREAMING
 					for (v = 0; v < L_NUM_VELS; v++) {
-						litefile << fNew(i,j,k,v,M_lim,K_lim,L_NUM_VELS) << "\t";
+						litefile << (bStored ? fNew[LBM_popIdx(i, j, k, v)] : 0.0) << "\t";
 					}
+#endif
 				
 #ifdef L_COMPUTE_TIME_AVERAGED_QUANTITIES
 					// Write out time averaged rho and u
@@ -1135,7 +1141,7 @@ int GridObj::io_hdf5(double tval)
 
 		// WRITE RHO
 		variable_name = time_string + "/Rho";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eScalar, this, &rho[0], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
@@ -1144,7 +1150,7 @@ int GridObj::io_hdf5(double tval)
 
 		// WRITE RHO_TIMEAV
 		variable_name = time_string + "/Rho_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eScalar, this, &rho_timeav[0], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
@@ -1159,14 +1165,14 @@ int GridObj::io_hdf5(double tval)
 
 		// WRITE UX
 		variable_name = time_string + "/Ux";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eVector, this, &u[0], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
 
 		// WRITE UY
 		variable_name = time_string + "/Uy";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eVector, this, &u[1], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
@@ -1174,7 +1180,7 @@ int GridObj::io_hdf5(double tval)
 		// WRITE UZ
 #if (L_DIMS == 3)
 		variable_name = time_string + "/Uz";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eVector, this, &u[2], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
@@ -1184,14 +1190,14 @@ int GridObj::io_hdf5(double tval)
 
 		// WRITE UX_TIMEAV
 		variable_name = time_string + "/Ux_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eVector, this, &ui_timeav[0], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
 
 		// WRITE UY_TIMEAV
 		variable_name = time_string + "/Uy_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eVector, this, &ui_timeav[1], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
@@ -1199,7 +1205,7 @@ int GridObj::io_hdf5(double tval)
 		// WRITE UZ_TIMEAV
 #if (L_DIMS == 3)
 		variable_name = time_string + "/Uz_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eVector, this, &ui_timeav[2], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
@@ -1212,21 +1218,21 @@ int GridObj::io_hdf5(double tval)
 
 		// WRITE UXUX_TIMEAV
 		variable_name = time_string + "/UxUx_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eProductVector, this, &uiuj_timeav[0], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
 
 		// WRITE UXUY_TIMEAV
 		variable_name = time_string + "/UxUy_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eProductVector, this, &uiuj_timeav[1], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
 
 		// WRITE UYUY_TIMEAV
 		variable_name = time_string + "/UyUy_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 #if (L_DIMS == 3)
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eProductVector, this, &uiuj_timeav[3], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 #else
@@ -1238,21 +1244,21 @@ int GridObj::io_hdf5(double tval)
 #if (L_DIMS == 3)
 		// WRITE UXUZ_TIMEAV
 		variable_name = time_string + "/UxUz_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eProductVector, this, &uiuj_timeav[2], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
 
 		// WRITE UYUZ_TIMEAV
 		variable_name = time_string + "/UyUz_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eProductVector, this, &uiuj_timeav[4], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
 
 		// WRITE UZUZ_TIMEAV
 		variable_name = time_string + "/UzUz_TimeAv";
-		dataset_id = H5Dcreate(file_id, variable_name.c_str(), H5T_NATIVE_DOUBLE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		dataset_id = H5Dcreate(file_id, variable_name.c_str(), L_HDF5_FIELD_TYPE, filespace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
 		hdf5_writeDataSet(memspace, filespace, dataset_id, eProductVector, this, &uiuj_timeav[5], H5T_NATIVE_DOUBLE, TL_present, TL_thickness, &minEdges[0], p_data);
 		status = H5Dclose(dataset_id); // Close dataset
 		if (status != 0) *GridUtils::logfile << "HDF5 ERROR: Close dataset failed: " << status << std::endl;
@@ -71,36 +71,36 @@ void GridObj::LBM_kbcCollide( int i, int j, int k, IVector<double>& f_new ) {
 	for (int v = 0; v < L_NUM_VELS; v++) {
 		
 		// Update feq
-		feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) = _LBM_equilibrium_opt(k + j * K_lim + i * K_lim * M_lim, v);
+		feq[LBM_popIdx(i, j, k, v)] = _LBM_equilibrium_opt(k + j * K_lim + i * K_lim * M_lim, v);
 
 		// These are actually rho * MXXX but no point in dividing to multiply later
-		M200 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v]);
-		M020 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[1][v]);
-		M002 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[2][v] * c[2][v]);
-		M110 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v]);
-		M101 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[2][v]);
-		M011 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[2][v]);
-		M111 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v] * c[2][v]);
-		M102 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[2][v] * c[2][v]);
-		M210 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v] * c[1][v]);
-		M021 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[1][v] * c[2][v]);
-		M201 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v] * c[2][v]);
-		M120 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v] * c[1][v]);
-		M012 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[2][v] * c[2][v]);
-
-		M200eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v]);
-		M020eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[1][v]);
-		M002eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[2][v] * c[2][v]);
-		M110eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v]);
-		M101eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[2][v]);
-		M011eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[2][v]);
-		M111eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v] * c[2][v]);
-		M102eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[2][v] * c[2][v]);
-		M210eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v] * c[1][v]);
-		M021eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[1][v] * c[2][v]);
-		M201eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v] * c[2][v]);
-		M120eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v] * c[1][v]);
-		M012eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[2][v] * c[2][v]);
+		M200 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v]);
+		M020 += f[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[1][v]);
+		M002 += f[LBM_popIdx(i, j, k, v)] * (c[2][v] * c[2][v]);
+		M110 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v]);
+		M101 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[2][v]);
+		M011 += f[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[2][v]);
+		M111 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v] * c[2][v]);
+		M102 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[2][v] * c[2][v]);
+		M210 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v] * c[1][v]);
+		M021 += f[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[1][v] * c[2][v]);
+		M201 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v] * c[2][v]);
+		M120 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v] * c[1][v]);
+		M012 += f[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[2][v] * c[2][v]);
+
+		M200eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v]);
+		M020eq += feq[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[1][v]);
+		M002eq += feq[LBM_popIdx(i, j, k, v)] * (c[2][v] * c[2][v]);
+		M110eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v]);
+		M101eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[2][v]);
+		M011eq += feq[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[2][v]);
+		M111eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v] * c[2][v]);
+		M102eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[2][v] * c[2][v]);
+		M210eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v] * c[1][v]);
+		M021eq += feq[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[1][v] * c[2][v]);
+		M201eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v] * c[2][v]);
+		M120eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v] * c[1][v]);
+		M012eq += feq[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[2][v] * c[2][v]);
 	}
 
 	// Compute ds
@@ -159,7 +159,7 @@ void GridObj::LBM_kbcCollide( int i, int j, int k, IVector<double>& f_new ) {
 
 
 		// Compute dh
-		dh[v] = f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) - feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) - ds[v];
+		dh[v] = f[LBM_popIdx(i, j, k, v)] - feq[LBM_popIdx(i, j, k, v)] - ds[v];
 
 	}
 
@@ -175,16 +175,16 @@ void GridObj::LBM_kbcCollide( int i, int j, int k, IVector<double>& f_new ) {
 	for (int v = 0; v < L_NUM_VELS; v++) {
 		
 		// Update feq
-		feq(i, j, k, v, M_lim, K_lim, L_NUM_VELS) = _LBM_equilibrium_opt(k + j * K_lim + i * M_lim * K_lim, v);
+		feq[LBM_popIdx(i, j, k, v)] = _LBM_equilibrium_opt(k + j * K_lim + i * M_lim * K_lim, v);
 		
 		// These are actually rho * MXX but no point in dividing to multiply later
-		M20 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v]);
-		M02 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[1][v]);
-		M11 += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v]);
+		M20 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v]);
+		M02 += f[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[1][v]);
+		M11 += f[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v]);
 
-		M20eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[0][v]);
-		M02eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[1][v] * c[1][v]);
-		M11eq += feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) * (c[0][v] * c[1][v]);
+		M20eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[0][v]);
+		M02eq += feq[LBM_popIdx(i, j, k, v)] * (c[1][v] * c[1][v]);
+		M11eq += feq[LBM_popIdx(i, j, k, v)] * (c[0][v] * c[1][v]);
 	}
 
 	// Compute ds
@@ -218,7 +218,7 @@ void GridObj::LBM_kbcCollide( int i, int j, int k, IVector<double>& f_new ) {
 
 
 		// Compute dh
-		dh[v] = f(i,j,k,v,M_lim,K_lim,L_NUM_VELS) - feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS) - ds[v];
+		dh[v] = f[LBM_popIdx(i, j, k, v)] - feq[LBM_popIdx(i, j, k, v)] - ds[v];
 
 	}
 
@@ -229,8 +229,8 @@ void GridObj::LBM_kbcCollide( int i, int j, int k, IVector<double>& f_new ) {
 	for (int v = 0; v < L_NUM_VELS; v++) {
 
 		// Compute scalar products
-		top_prod += ds[v] * dh[v] / feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS);
-		bot_prod += dh[v] * dh[v] / feq(i,j,k,v,M_lim,K_lim,L_NUM_VELS);
+		top_prod += ds[v] * dh[v] / feq[LBM_popIdx(i, j, k, v)];
+		bot_prod += dh[v] * dh[v] / feq[LBM_popIdx(i, j, k, v)];
 
 	}
 	
@@ -242,12 +242,12 @@ void GridObj::LBM_kbcCollide( int i, int j, int k, IVector<double>& f_new ) {
 	for (int v = 0; v < L_NUM_VELS; v++) {
 
 		// Perform collision
-		f_new(i, j, k, v, M_lim, K_lim, L_NUM_VELS) =
-			f(i, j, k, v, M_lim, K_lim, L_NUM_VELS) -
+		f_new[LBM_popIdx(i, j, k, v)] =
+			f[LBM_popIdx(i, j, k, v)] -
 			(omega / 2) * (2 * ds[v] + gamma * dh[v])
 
 #if (defined L_GRAVITY_ON || defined L_IBM_ON)
-			+ force_i(i,j,k,v,M_lim,K_lim,L_NUM_VELS)
+			+ force_i[LBM_popIdx(i, j, k, v)]
 #endif
 			;
 	}
@@ -308,12 +308,12 @@ void GridObj::LBM_macro( int i, int j, int k ) {
 		for (int v = 0; v < L_NUM_VELS; v++) {
 
 			// Sum up to find mass flux
-			fux_temp += (double)c[0][v] * f(i,j,k,v,M_lim,K_lim,L_NUM_VELS);
-			fuy_temp += (double)c[1][v] * f(i,j,k,v,M_lim,K_lim,L_NUM_VELS);
-			fuz_temp += (double)c[2][v] * f(i,j,k,v,M_lim,K_lim,L_NUM_VELS);
+			fux_temp += (double)c[0][v] * f[LBM_fIdx(i, j, k, v)];
+			fuy_temp += (double)c[1][v] * f[LBM_fIdx(i, j, k, v)];
+			fuz_temp += (double)c[2][v] * f[LBM_fIdx(i, j, k, v)];
 
 			// Sum up to find density
-			rho_temp += f(i,j,k,v,M_lim,K_lim,L_NUM_VELS);
+			rho_temp += f[LBM_fIdx(i, j, k, v)];
 
 		}
 
@@ -23,14 +23,20 @@
 #include "../inc/stdafx.h"
 #include "../inc/GridObj.h"
 #include "../inc/ObjectManager.h"
-
-#include "../inc/Matrix.h"
+#ifdef L_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 // *****************************************************************************
 /// \brief	Optimised LBM multi-grid kernel.
 ///
 ///			This kernel compresses the old kernel into a single loop in order to
-///			make it more efficient.
+///			make it more efficient. Each site is streamed into a local buffer which
+///			is written back to fNew, or to f in place if L_INPLACE_STREAMING is 
+///			defined, once collided. On grids using sparse storage only the active
+///			sites are visited. If L_MPI_OVERLAP is defined the sites on the MPI 
+///			halo are updated first and their exchange is posted before the 
+///			interior is updated.
 ///
 ///	\param	subcycle	sub-cycle to be performed if called from a subgrid.
 void GridObj::LBM_multi_opt(int subcycle)
@@ -65,53 +71,29 @@ void GridObj::LBM_multi_opt(int subcycle)
 	objman->resetMomexBodyForces(this);
 #endif
 
+	// Only write macroscopic quantities back to the grid when they are needed
+	bStoreMacro = _LBM_isMacroStoreStep();
+
+	// Full range of sparse sites
+	int sparseEnd = static_cast<int>(sparseSites.size());
+
 	// Loop over grid
-#ifdef L_ENABLE_OPENMP
-#pragma omp parallel for
+#if (defined L_BUILD_FOR_MPI && defined L_MPI_OVERLAP && !defined L_IBM_ON)
+	// Update the MPI halo first and exchange it while the interior is updated
+	_LBM_kernelPass_opt(shellTiles, 0, sparseShellEnd, subcycle, false);
+	MpiManager::getInstance()->mpi_communicateStart(level, region_number, fNew.data());
+	_LBM_kernelPass_opt(innerTiles, sparseShellEnd, sparseEnd, subcycle, false);
+#else
+	_LBM_kernelPass_opt(tiles, 0, sparseEnd, subcycle, false);
 #endif
-	for (int i = 0; i < N_lim; ++i)
-	{
-		for (int j = 0; j < M_lim; ++j)
-		{
-			for (int k = 0; k < K_lim; ++k)
-			{
-				// Local index and type
-				int id = k + j * K_lim + i * K_lim * M_lim;
-				eType type_local = LatTyp[id];
 
-				// MOMENTUM EXCHANGE //
 #ifdef L_LD_OUT
-				if (type_local == eSolid)
-				{
-					// Compute lift and drag contribution of this site
-					objman->computeLiftDrag(i, j, k, this);
-				}
-#endif
-				// IGNORE THESE SITES //
-				if (type_local == eRefined || type_local == eSolid
-#ifndef L_REGULARISED_BOUNDARIES
-					|| type_local == eVelocity
-#endif
-					) continue;
-
-				// STREAM //
-				_LBM_stream_opt(i, j, k, id, type_local, subcycle);
-
-				// REGULARISED BCs //
-#ifdef L_REGULARISED_BOUNDARIES
-				if (type_local == eVelocity || type_local == ePressure)
-					_LBM_regularised_opt(i, j, k, id, type_local, subcycle);
+	// Add up the momentum exchange forces of each thread
+	objman->sumMomexBodyForces();
 #endif
 
-				// MACROSCOPIC //
-				_LBM_macro_opt(i, j, k, id, type_local);
-
-				// If IBM is on then split loop and perform IBM step
+	// If IBM is on then split loop and perform IBM step
 #ifdef L_IBM_ON
-			}
-		}
-	}
-
 	// Set post-LBM macros
 	if (objman->hasFlexibleBodies[level])
 		u_n = u;
@@ -120,43 +102,21 @@ void GridObj::LBM_multi_opt(int subcycle)
 	if (objman->hasIBMBodies[level])
 		objman->ibm_apply(this, true);
 
-
 	// Loop over grid
-	for (int i = 0; i < N_lim; ++i)
-	{
-		for (int j = 0; j < M_lim; ++j)
-		{
-			for (int k = 0; k < K_lim; ++k)
-			{
-				// Local index and type
-				int id = k + j * K_lim + i * K_lim * M_lim;
-				eType type_local = LatTyp[id];
-
-#endif
-
-				// FORCING //
-#if (defined L_IBM_ON || defined L_GRAVITY_ON)
-				// Do not force solid sites
-				if (type_local != eSolid)
-					_LBM_forceGrid_opt(id);
-#endif
-				// COLLIDE //
-				if (type_local != eTransitionToCoarser) // Do not collide on UpperTL
-				{ 
-
-#ifdef L_USE_KBC_COLLISION
-					_LBM_kbcCollide_opt(id);
+#if (defined L_BUILD_FOR_MPI && defined L_MPI_OVERLAP)
+	// Collide the MPI halo first and exchange it while the interior is collided
+	_LBM_kernelPass_opt(shellTiles, 0, sparseShellEnd, subcycle, true);
+	MpiManager::getInstance()->mpi_communicateStart(level, region_number, fNew.data());
+	_LBM_kernelPass_opt(innerTiles, sparseShellEnd, sparseEnd, subcycle, true);
 #else
-					_LBM_collide_opt(id);
+	_LBM_kernelPass_opt(tiles, 0, sparseEnd, subcycle, true);
+#endif
 #endif
-				}
-
-			}
-		}
-	}
 
+#ifndef L_INPLACE_STREAMING
 	// Swap distributions
 	f.swap(fNew);
+#endif
 
 #ifdef L_MOMEX_DEBUG
 	if (level == objman->bbbOnGridLevel && region_number == objman->bbbOnGridReg)
@@ -185,109 +145,720 @@ void GridObj::LBM_multi_opt(int subcycle)
 	// MPI COMMUNICATION //
 #ifdef L_BUILD_FOR_MPI
 
+#ifdef L_MPI_OVERLAP
+	// Complete the exchange posted during the step
+	MpiManager::getInstance()->mpi_communicateFinish(level, region_number);
+#else
 	// Launch communication on this grid by passing its level and region number
 	MpiManager::getInstance()->mpi_communicate(level, region_number);
+#endif
 
 #endif
 
 }
 
+// *****************************************************************************
+/// \brief	Stream, and collide unless IBM is on, a set of sites of this grid.
+///
+///			With L_COLLIDE_BATCH each thread hands its sites to a batch which is
+///			collided and stored whenever it fills and at the end of the pass.
+///
+///	\param	tileList		tiles to visit if the grid uses dense storage.
+///	\param	sparseBegin		first position in sparseSites to visit if the grid uses sparse storage.
+///	\param	sparseEnd		position in sparseSites after the last to visit.
+///	\param	subcycle		sub-cycle to be performed if called from a subgrid.
+///	\param	bCollideOnly	collide sites which have already been streamed.
+#ifdef L_SPARSE_STORAGE
+void GridObj::_LBM_kernelPass_opt(const std::vector<int> &tileList, int sparseBegin, int sparseEnd, int subcycle, bool bCollideOnly)
+#else
+void GridObj::_LBM_kernelPass_opt(const std::vector<int> &tileList, int UNUSED(sparseBegin), int UNUSED(sparseEnd), int subcycle, bool bCollideOnly)
+#endif
+{
+#ifdef L_ENABLE_OPENMP
+#pragma omp parallel
+#endif
+	{
+#ifdef L_COLLIDE_BATCH
+		// Sites of this thread waiting to be collided
+		CollideBatch batchStore;
+		CollideBatch *batch = &batchStore;
+#else
+		CollideBatch *batch = nullptr;
+#endif
 
+#ifdef L_SPARSE_STORAGE
+		if (bSparse)
+		{
+			// Only visit sites which have storage
+#ifdef L_ENABLE_OPENMP
+#pragma omp for schedule(static)
+#endif
+			for (int n = sparseBegin; n < sparseEnd; n += 3)
+			{
+				if (bCollideOnly) _LBM_collideStreamedSite_opt(sparseSites[n], sparseSites[n + 1], sparseSites[n + 2], batch);
+				else _LBM_streamSite_opt(sparseSites[n], sparseSites[n + 1], sparseSites[n + 2], subcycle, batch);
+			}
+		}
+		else
+#endif
+		{
+			// Visit the grid tile by tile so neighbouring planes stay in cache
+#ifdef L_ENABLE_OPENMP
+#pragma omp for schedule(static)
+#endif
+			for (int n = 0; n < static_cast<int>(tileList.size()); n += 6)
+			{
+				for (int i = tileList[n]; i < tileList[n + 1]; ++i)
+				{
+					for (int j = tileList[n + 2]; j < tileList[n + 3]; ++j)
+					{
+						for (int k = tileList[n + 4]; k < tileList[n + 5]; ++k)
+						{
+							if (bCollideOnly) _LBM_collideStreamedSite_opt(i, j, k, batch);
+							else _LBM_streamSite_opt(i, j, k, subcycle, batch);
+						}
+					}
+				}
+			}
+		}
+
+#ifdef L_COLLIDE_BATCH
+		// Remainder of the last batch
+		_LBM_collideBatch_opt(batchStore);
+#endif
+	}
+}
 
 // *****************************************************************************
-/// \brief	Optimised stream operation.
+/// \brief	Temporally blocked LBM kernel for grids without sub-grids.
 ///
-/// \param	i	x-index of current site.
-/// \param	j	y-index of current site.
-/// \param	k	z-index of current site.
-///	\param	id	flattened ijk index.
-///	\param	type_local	type of current site.
-///	\param	subcycle	number of sub-cycle being performed.
-void GridObj::_LBM_stream_opt(int i, int j, int k, int id, eType type_local, int subcycle)
+///			Advances several time steps in a single pass over the grid. The
+///			x-planes are swept by a wavefront in which time level s+1 trails
+///			level s by one plane, so the planes a level pulls from are still
+///			in cache from the level before. With the pull scheme a plane only
+///			overwrites populations two levels old, which the levels ahead have
+///			already finished with, so f and fNew are sufficient.
+///
+///			Sites within s sites of the grid edges are wrong after s levels as
+///			they pull across the local wrap. The MPI halo is therefore
+///			L_TEMPORAL_BLOCKING sites thick and is only exchanged at the end of
+///			the sweep. A sweep stops early on steps where the main loop writes
+///			out.
+void GridObj::LBM_multiBlocked_opt()
 {
+	// Start the clock to time this kernel
+	clock_t secs, t_start = clock();
 
-	// Local value to save multiple loads
-	eType src_type_local;
+	int t0 = t;
+	int steps = _LBM_sweepLength();
+	bool bSwapped = false;
 
-	// Loop over velocities
-	for (int v = 0; v < L_NUM_VELS; ++v)
+	// Wavefront over the planes
+	for (int w = 0; w < N_lim + steps - 1; ++w)
 	{
-		// Get indicies for source site (periodic by default)
-		int src_x = (i - c_opt[v][0] + N_lim) % N_lim;
-		int src_y = (j - c_opt[v][1] + M_lim) % M_lim;
-		int src_z = (k - c_opt[v][2] + K_lim) % K_lim;
+		for (int s = 0; s < steps; ++s)
+		{
+			int i = w - s;
+			if (i < 0 || i >= N_lim) continue;
 
-		// Source id and type
-		int src_id = src_z + src_y * K_lim + src_x * K_lim * M_lim;
-		src_type_local = LatTyp[src_id];
+			// Read level s from f and write level s + 1 to fNew
+			if (bSwapped != (s % 2 == 1))
+			{
+				f.swap(fNew);
+				bSwapped = !bSwapped;
+			}
+			t = t0 + s;
 
-		// BFL BOUNCEBACK
-		if (type_local == eBFL || src_type_local == eBFL)
-		{
-			// Try to apply BFL BC on streaming link
-			if (_LBM_applyBFL_opt(id, src_id, v, i, j, k, src_x, src_y, src_z)) continue;
+#ifdef L_REYNOLDS_RAMP
+			// Update the Reynolds number if ramping up
+			_LBM_updateReynolds(static_cast<double>(L_RE) * GridUtils::getReynoldsRampCoefficient((t + 1) * dt));
+#endif
+			bStoreMacro = _LBM_isMacroStoreStep();
+
+#ifdef L_ENABLE_OPENMP
+#pragma omp parallel for schedule(static)
+#endif
+			for (int j = 0; j < M_lim; ++j)
+			{
+				for (int k = 0; k < K_lim; ++k)
+				{
+					_LBM_streamSite_opt(i, j, k, 0);
+				}
+			}
 		}
+	}
+
+	// Leave the newest populations in f
+	if (bSwapped != (steps % 2 == 1))
+		f.swap(fNew);
+	t = t0 + steps;
+
+	// Get time of sweep
+	secs = clock() - t_start;
+
+	// Update average timestep time on this grid
+	timeav_timestep *= t0;
+	timeav_timestep += ((double)secs) / CLOCKS_PER_SEC;
+	timeav_timestep /= t;
+
+	if (t % L_GRID_OUT_FREQ == 0) {
+		// Performance data to logfile
+		*GridUtils::logfile << "Grid " << level << ": Time stepping taking an average of " << timeav_timestep * 1000 << "ms" << std::endl;
+	}
+
+	// MPI COMMUNICATION //
+#ifdef L_BUILD_FOR_MPI
+
+	// Refresh the whole halo once per sweep
+	MpiManager::getInstance()->mpi_communicate(level, region_number);
+
+#endif
+
+}
+
+// *****************************************************************************
+/// \brief	Multi-grid kernel which advances the grid hierarchy concurrently.
+///
+///			Called on the top-level grid in place of LBM_multi_opt. The grids
+///			of a level are advanced together so that sibling regions share one
+///			work list, and the tiles of a parent which do not touch its 
+///			sub-grids are streamed alongside the first sub-cycle of the 
+///			children rather than after both.
+void GridObj::LBM_multiConcurrent_opt()
+{
+	_LBM_advanceConcurrent(std::vector<GridObj*>(1, this), 0, std::vector<GridObj*>(), 0);
+}
 
-		// SLIP CONDITIONS //
-		if (type_local == eSlip)
+// *****************************************************************************
+/// \brief	Advance a set of grids on the same level by one time step.
+///
+///			The children of the set are sub-cycled first, recursively. The
+///			uncoupled tiles of each parent only read the parent's own f, and the
+///			children only read f of the parent, which is not swapped until the 
+///			end of the step, so those tiles join the first sub-cycle of the 
+///			children. The remaining work of the set is then shared out between
+///			the threads in a single dynamically scheduled loop. Communication 
+///			stays on the calling thread and is issued in region order so every
+///			rank posts its messages in the same sequence.
+///
+/// \param	grids				grids to advance.
+/// \param	subcycle			sub-cycle being performed by the grids.
+/// \param	overlap				parents whose uncoupled tiles are streamed with this set.
+/// \param	overlapSubcycle		sub-cycle being performed by the parents.
+void GridObj::_LBM_advanceConcurrent(const std::vector<GridObj*> &grids, int subcycle, 
+	const std::vector<GridObj*> &overlap, int overlapSubcycle)
+{
+	// Range of tiles or sparse sites of a grid
+	struct WorkItem { GridObj *g; int start; int end; int subcycle; };
+	std::vector<WorkItem> work;
+
+	// Start the step on each grid
+	std::vector<GridObj*> children;
+	std::vector<GridObj*> parents;
+	for (GridObj *g : grids)
+	{
+#ifdef L_REYNOLDS_RAMP
+		// Update the Reynolds number if ramping up
+		g->_LBM_updateReynolds(static_cast<double>(L_RE) * GridUtils::getReynoldsRampCoefficient((g->t + 1) * g->dt));
+#endif
+		g->bStoreMacro = g->_LBM_isMacroStoreStep();
+		children.insert(children.end(), g->subGrid.begin(), g->subGrid.end());
+		if (!g->subGrid.empty() && !g->bSparse) parents.push_back(g);
+	}
+
+	// Two iterations on sub-grids
+	if (!children.empty())
+	{
+		_LBM_advanceConcurrent(children, 0, parents, subcycle);
+		_LBM_advanceConcurrent(children, 1, std::vector<GridObj*>(), 0);
+	}
+
+	// Collect the work left on this level
+#ifdef L_SPARSE_STORAGE
+	int threads = 1;
+#ifdef L_ENABLE_OPENMP
+	threads = omp_get_max_threads();
+#endif
+#endif
+	for (GridObj *g : grids)
+	{
+#ifdef L_SPARSE_STORAGE
+		if (g->bSparse)
 		{
-			if (_LBM_applySpecReflect_opt(i, j, k, id, v)) continue;
+			// Several chunks of sites per thread to balance with the other grids
+			int size = static_cast<int>(g->sparseSites.size());
+			int chunk = 3 * std::max(1, size / (3 * 4 * threads));
+			for (int n = 0; n < size; n += chunk)
+				work.push_back({ g, n, std::min(n + chunk, size), subcycle });
+			continue;
 		}
+#endif
+		// Parents have already streamed their uncoupled tiles
+		for (int n = 0; n < static_cast<int>(g->tiles.size()); n += 6)
+		{
+			if (g->subGrid.empty() || g->tileCoupled[n / 6])
+				work.push_back({ g, n, n + 6, subcycle });
+		}
+	}
+	for (GridObj *p : overlap)
+	{
+		for (int n = 0; n < static_cast<int>(p->tiles.size()); n += 6)
+		{
+			if (!p->tileCoupled[n / 6])
+				work.push_back({ p, n, n + 6, overlapSubcycle });
+		}
+	}
+
+#ifdef L_ENABLE_OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int w = 0; w < static_cast<int>(work.size()); ++w)
+	{
+		// Time each item so it is charged to the grid it belongs to
+#ifdef L_ENABLE_OPENMP
+		double t_start = omp_get_wtime();
+#else
+		double t_start = static_cast<double>(clock()) / CLOCKS_PER_SEC;
+#endif
 
-		// BOUNCEBACK
-		if (src_type_local == eSolid)
+		GridObj *g = work[w].g;
+#ifdef L_SPARSE_STORAGE
+		if (g->bSparse)
 		{
-			// F value is its opposite (HWBB)
-			fNew[v + id * L_NUM_VELS] =
-				f[GridUtils::getOpposite(v) + id * L_NUM_VELS];
+			for (int n = work[w].start; n < work[w].end; n += 3)
+				g->_LBM_streamSite_opt(g->sparseSites[n], g->sparseSites[n + 1], g->sparseSites[n + 2], work[w].subcycle);
+		}
+		else
+#endif
+		{
+			const int *tile = &g->tiles[work[w].start];
+			for (int i = tile[0]; i < tile[1]; ++i)
+			{
+				for (int j = tile[2]; j < tile[3]; ++j)
+				{
+					for (int k = tile[4]; k < tile[5]; ++k)
+					{
+						g->_LBM_streamSite_opt(i, j, k, work[w].subcycle);
+					}
+				}
+			}
 		}
 
-		// VELOCITY BC (forced equilbirium)
+#ifdef L_ENABLE_OPENMP
+		// Share of the step across the team so the sum compares with an uncontended loop
+		double secs = (omp_get_wtime() - t_start) / omp_get_num_threads();
+#pragma omp atomic
+		g->step_secs += secs;
+#else
+		g->step_secs += static_cast<double>(clock()) / CLOCKS_PER_SEC - t_start;
+#endif
+	}
+
+	for (GridObj *g : grids)
+	{
+		// Swap distributions
+		g->f.swap(g->fNew);
+
+		// Increment internal loop counter
+		++g->t;
+
+		// Update average timestep time on this grid (including any tiles streamed 
+		// alongside the children)
+		g->timeav_timestep *= (g->t - 1);
+		g->timeav_timestep += g->step_secs;
+		g->timeav_timestep /= g->t;
+		g->step_secs = 0.0;
+
+		if (g->t % L_GRID_OUT_FREQ == 0) {
+			// Performance data to logfile
+			*GridUtils::logfile << "Grid " << g->level << ": Time stepping taking an average of " << g->timeav_timestep * 1000 << "ms" << std::endl;
+		}
+	}
+
+	// MPI COMMUNICATION //
+#ifdef L_BUILD_FOR_MPI
+
+	// Launch communication on each grid in turn
+	for (GridObj *g : grids)
+		MpiManager::getInstance()->mpi_communicate(g->level, g->region_number);
+
+#endif
+
+}
+
+// *****************************************************************************
+/// \brief	Number of time steps to advance in the next temporally blocked sweep.
+///
+///			Sweeps are aligned to multiples of L_TEMPORAL_BLOCKING and are cut
+///			short so that they end on every step which the main loop writes out.
+///
+/// \return	number of time steps.
+int GridObj::_LBM_sweepLength()
+{
+	int steps = 1;
+#ifdef L_TEMPORAL_BLOCKING
+	const int freqs[] = { L_TEMPORAL_BLOCKING, L_GRID_OUT_FREQ, L_EXTRA_OUT_FREQ, L_RESTART_OUT_FREQ, L_TOTAL_TIMESTEPS
+#ifdef L_PROBE_OUTPUT
+		, L_PROBE_OUT_FREQ
+#endif
+	};
+	steps = L_TEMPORAL_BLOCKING;
+	for (int freq : freqs)
+		steps = std::min(steps, freq - t % freq);
+#endif
+	return steps;
+}
+
+
+
+// *****************************************************************************
+/// \brief	Stream a single site.
+///
+///			Performs the momentum exchange, stream, regularised BCs and 
+///			macroscopic update for a site. Unless the kernel is split by the IBM
+///			step the site is then collided straight away.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	subcycle	number of sub-cycle being performed.
+///	\param	batch		batch to collide the site in (collided straight away if null).
+#ifndef L_IBM_ON
+void GridObj::_LBM_streamSite_opt(int i, int j, int k, int subcycle, CollideBatch *batch)
+#else
+void GridObj::_LBM_streamSite_opt(int i, int j, int k, int subcycle, CollideBatch *UNUSED(batch))
+#endif
+{
+	// Local index and type
+	int id = k + j * K_lim + i * K_lim * M_lim;
+	eType type_local = LatTyp[id];
+
+	// MOMENTUM EXCHANGE //
+#ifdef L_LD_OUT
+	if (type_local == eSolid)
+	{
+		// Compute lift and drag contribution of this site
+		ObjectManager::getInstance()->computeLiftDrag(i, j, k, this);
+	}
+#endif
+	// IGNORE THESE SITES //
+	if (type_local == eRefined || type_local == eSolid
 #ifndef L_REGULARISED_BOUNDARIES
-		else if (src_type_local == eVelocity)
+		|| type_local == eVelocity
+#endif
+		) return;
+
+	// Populations of this site for the current time step
+	double f_local[L_NUM_VELS];
+
+	// STREAM //
+	_LBM_stream_opt(i, j, k, id, type_local, subcycle, f_local);
+
+	// REGULARISED BCs //
+#ifdef L_REGULARISED_BOUNDARIES
+	if (type_local == eVelocity || type_local == ePressure)
+		_LBM_regularised_opt(i, j, k, id, type_local, subcycle, f_local);
+#endif
+
+	// MACROSCOPIC (kept locally for the collision) //
+	double rho_local, u_local[L_DIMS];
+	_LBM_macro_opt(i, j, k, id, type_local, f_local, rho_local, u_local, bStoreMacro);
+
+	// TIME-AVERAGED QUANTITIES //
+#ifdef L_COMPUTE_TIME_AVERAGED_QUANTITIES
+	_LBM_timeAverage_opt(id, rho_local, u_local);
+#endif
+
+#ifdef L_IBM_ON
+	// Hold post-stream populations until after the IBM step
+	_LBM_storeStreamed_opt(i, j, k, id, f_local);
+#else
+	// FORCE AND COLLIDE //
+	_LBM_collideSite_opt(i, j, k, id, type_local, f_local, rho_local, u_local, batch);
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Collide a site which was streamed before the IBM step.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	batch	batch to collide the site in (collided straight away if null).
+void GridObj::_LBM_collideStreamedSite_opt(int i, int j, int k, CollideBatch *batch)
+{
+	// Local index and type
+	int id = k + j * K_lim + i * K_lim * M_lim;
+	eType type_local = LatTyp[id];
+
+#ifdef L_INPLACE_STREAMING
+	// Sites which were not streamed do not own any populations
+	if (type_local == eRefined || type_local == eSolid
+#ifndef L_REGULARISED_BOUNDARIES
+		|| type_local == eVelocity
+#endif
+		) return;
+#endif
+
+	// Retrieve post-stream populations
+	double f_local[L_NUM_VELS];
+	_LBM_loadStreamed_opt(i, j, k, id, f_local);
+
+	// Retrieve macroscopic quantities (modified by the IBM step)
+	double rho_local = rho[id];
+	double u_local[L_DIMS];
+	for (int d = 0; d < L_DIMS; ++d)
+		u_local[d] = u[d + id * L_DIMS];
+
+	// FORCE AND COLLIDE //
+	_LBM_collideSite_opt(i, j, k, id, type_local, f_local, rho_local, u_local, batch);
+}
+
+// *****************************************************************************
+/// \brief	Force and collide a single site and store the result.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	id	flattened ijk index.
+///	\param	type_local	type of current site.
+///	\param	f_local		post-stream populations of the current site.
+///	\param	rho_local	density of the current site.
+///	\param	u_local		velocity of the current site.
+///	\param	batch		batch to collide and store the site in (done straight away if null).
+#ifdef L_COLLIDE_BATCH
+void GridObj::_LBM_collideSite_opt(int i, int j, int k, int id, eType type_local, double *f_local,
+								   double rho_local, const double *u_local, CollideBatch *batch)
+#else
+void GridObj::_LBM_collideSite_opt(int i, int j, int k, int id, eType type_local, double *f_local,
+								   double rho_local, const double *u_local, CollideBatch *UNUSED(batch))
+#endif
+{
+	// FORCING //
+#if (defined L_IBM_ON || defined L_GRAVITY_ON)
+	// Do not force solid sites
+	if (type_local != eSolid)
+		_LBM_forceGrid_opt(id, u_local);
+#endif
+	// COLLIDE //
+	if (type_local != eTransitionToCoarser) // Do not collide on UpperTL
+	{ 
+
+#ifdef L_COLLIDE_BATCH
+		if (batch)
+		{
+			// Hold the site back to be collided and stored with the rest of the batch
+			int s = batch->size++;
+			for (int v = 0; v < L_NUM_VELS; ++v)
+				batch->f[v][s] = f_local[v];
+			batch->rho[s] = rho_local;
+			for (int d = 0; d < L_DIMS; ++d)
+				batch->u[d][s] = u_local[d];
+			batch->site[0][s] = i;
+			batch->site[1][s] = j;
+			batch->site[2][s] = k;
+			batch->site[3][s] = id;
+
+			if (batch->size == L_COLLIDE_BATCH) _LBM_collideBatch_opt(*batch);
+			return;
+		}
+#endif
+
+#ifdef L_USE_KBC_COLLISION
+		_LBM_kbcCollide_opt(id, f_local);
+#else
+		_LBM_collide_opt(id, f_local, rho_local, u_local);
+#endif
+	}
+
+	// Write populations back for the next time step
+	_LBM_storeCollided_opt(i, j, k, id, f_local);
+}
+
+// *****************************************************************************
+/// \brief	Optimised stream operation.
+///
+///			All links are first pulled regularly from their source sites without
+///			checking any site labels. The boundary links of the site are then 
+///			revisited and overwritten with the appropriate treatment.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	id	flattened ijk index.
+///	\param	type_local	type of current site.
+///	\param	subcycle	number of sub-cycle being performed.
+///	\param	f_local		populations of the current site once streamed.
+void GridObj::_LBM_stream_opt(int i, int j, int k, int id, eType type_local, int subcycle, double *f_local)
+{
+
+	// REGULAR STREAM //
+#ifdef L_INPLACE_STREAMING
+	if (t % 2 == 0)
+	{
+		// Already pushed to this site by the previous time step
+		for (int v = 0; v < L_NUM_VELS; ++v)
+			f_local[v] = f[LBM_popIdx(id, v)];
+	}
+	else
+#endif
+	{
+		// Sites on the edge of the grid pull across the periodic wrap
+		bool bEdgeSite = (i == 0 || i == N_lim - 1 || j == 0 || j == M_lim - 1
+#if (L_DIMS == 3)
+			|| k == 0 || k == K_lim - 1
+#endif
+			);
+
+		// Loop over velocities
+		for (int v = 0; v < L_NUM_VELS; ++v)
 		{
+			// Source site (periodic by default)
+			int src_id = bEdgeSite ?
+				streamSrcZ[k + v * K_lim] + streamSrcY[j + v * M_lim] * K_lim + streamSrcX[i + v * N_lim] * K_lim * M_lim :
+				id + streamOffset[v];
+
+			// Pull population from source site
+#ifdef L_INPLACE_STREAMING
+			f_local[v] = f[LBM_popIdx(src_id, GridUtils::getOpposite(v))];
+#else
+			f_local[v] = f[LBM_popIdx(src_id, v)];
+#endif
+		}
+	}
+
+	// BOUNDARY LINKS //
+	for (int n = linkStart[id]; n < linkStart[id + 1]; ++n)
+		_LBM_streamLink_opt(i, j, k, id, type_local, linkDir[n], linkType[n], subcycle, f_local);
+
+}
+
+// *****************************************************************************
+/// \brief	Apply the treatment of a single boundary link.
+///
+///			BFL and slip links which turn out not to be cut by a wall revert to
+///			the treatment implied by the site labels.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	id	flattened ijk index.
+///	\param	type_local	type of current site.
+///	\param	v	lattice direction of link.
+///	\param	link_type	treatment of link.
+///	\param	subcycle	number of sub-cycle being performed.
+///	\param	f_local		populations of the current site once streamed.
+void GridObj::_LBM_streamLink_opt(int i, int j, int k, int id, eType type_local, int v, eLinkType link_type, int subcycle, double *f_local)
+{
+	// Source site (periodic by default)
+	int src_x = streamSrcX[i + v * N_lim];
+	int src_y = streamSrcY[j + v * M_lim];
+	int src_z = streamSrcZ[k + v * K_lim];
+	int src_id = src_z + src_y * K_lim + src_x * K_lim * M_lim;
+
+	// BFL BOUNCEBACK
+	if (link_type == eBFLLink)
+	{
+		// Try to apply BFL BC on streaming link
+		if (_LBM_applyBFL_opt(id, src_id, v, i, j, k, src_x, src_y, src_z, f_local)) return;
+		link_type = _LBM_getLinkType(type_local, LatTyp[src_id], eSlipLink);
+	}
+
+	// SLIP CONDITIONS //
+	if (link_type == eSlipLink)
+	{
+		if (_LBM_applySpecReflect_opt(i, j, k, id, v, f_local)) return;
+		link_type = _LBM_getLinkType(type_local, LatTyp[src_id], eBounceBackLink);
+	}
+
+	switch (link_type)
+	{
+
+	// BOUNCEBACK
+	case eBounceBackLink:
+
+		// F value is its opposite (HWBB)
+		f_local[v] = f[LBM_fIdx(i, j, k, GridUtils::getOpposite(v))];
+		break;
+
+	// VELOCITY BC (forced equilbirium)
+	case eVelocityLink:
 
 #ifdef L_VELOCITY_RAMP
+		{
 			double rampCoefficient = GridUtils::getVelocityRampCoefficient(t * dt);
 			u[0 + src_id * L_DIMS] = ux_in[j] * rampCoefficient;
 			u[1 + src_id * L_DIMS] = uy_in[j] * rampCoefficient;
 #if (L_DIMS == 3)
 			u[2 + src_id * L_DIMS] = uz_in[j] * rampCoefficient;
 #endif
-
-#endif
-			// Set f to equilibrium (forced equilibrium BC)
-			fNew[v + id * L_NUM_VELS] = _LBM_equilibrium_opt(src_id, v);
 		}
 #endif
+		// Set f to equilibrium (forced equilibrium BC)
+		f_local[v] = _LBM_equilibrium_opt(src_id, v);
+		break;
 
-#if (L_NUM_LEVELS > 0)	// Only need to check these options when using refinement
-		// EXPLODE
-		else if (src_type_local == eTransitionToCoarser && subcycle == 0)
-		{
-			// Pull value from parent TL site
-			_LBM_explode_opt(id, v, src_x, src_y, src_z);
-		}
+	// EXPLODE
+	case eExplodeLink:
 
-		// COALESCE
-		else if (src_type_local == eRefined && type_local == eTransitionToFiner)
-		{
-			// Pull average value from child TL cluster to get value leaving fine grid
-			_LBM_coalesce_opt(i, j, k, id, v);
-		}
-#endif
+		// Pull value from parent TL site (regular stream on second sub-cycle)
+		if (subcycle == 0)
+			f_local[v] = _LBM_explode_opt(id, v, src_x, src_y, src_z);
+		break;
 
-		// REGULAR STREAM
-		else
-		{
-			// Pull population from source site
-			fNew[v + id * L_NUM_VELS] = f[v + src_id * L_NUM_VELS];
-		}
+	// COALESCE
+	case eCoalesceLink:
+
+		// Pull average value from child TL cluster to get value leaving fine grid
+		f_local[v] = _LBM_coalesce_opt(i, j, k, id, v);
+		break;
+
+	// REGULAR STREAM (already pulled)
+	default:
+		break;
 
 	}
 
 }
 
+// *****************************************************************************
+/// \brief	Get the treatment of a streaming link from the site labels.
+///
+/// \param	type_local		type of current site.
+/// \param	src_type_local	type of source site.
+/// \param	first			treatment with the highest precedence to consider.
+/// \return					treatment of link.
+eLinkType GridObj::_LBM_getLinkType(eType type_local, eType src_type_local, eLinkType first)
+{
+	if (first <= eBFLLink && (type_local == eBFL || src_type_local == eBFL))
+		return eBFLLink;
+
+	if (first <= eSlipLink && type_local == eSlip)
+		return eSlipLink;
+
+	if (src_type_local == eSolid)
+		return eBounceBackLink;
+
+#ifndef L_REGULARISED_BOUNDARIES
+	if (src_type_local == eVelocity)
+		return eVelocityLink;
+#endif
+
+#if (L_NUM_LEVELS > 0)	// Only need to check these options when using refinement
+	if (src_type_local == eTransitionToCoarser)
+		return eExplodeLink;
+
+	// Fine sites next to a dropped refinement block pull from its parent
+	if (src_type_local == eRefined && type_local == eTransitionToCoarser)
+		return eExplodeLink;
+
+	if (src_type_local == eRefined && type_local == eTransitionToFiner)
+		return eCoalesceLink;
+#endif
+
+	return eRegularLink;
+}
+
 // *****************************************************************************
 /// \brief	Optimised application of regularised BC
 ///
@@ -302,7 +873,8 @@ void GridObj::_LBM_stream_opt(int i, int j, int k, int id, eType type_local, int
 ///	\param	id			flattened ijk index.
 ///	\param	type		lattice type (assumed to be either velocity or pressure)
 ///	\param	subcycle	number of sub-cycle being performed.
-void GridObj::_LBM_regularised_opt(int i, int j, int k, int id, eType type, int subcycle)
+///	\param	f_local		streamed populations of the current site.
+void GridObj::_LBM_regularised_opt(int i, int j, int k, int id, eType type, int subcycle, double *f_local)
 {
 	// Declarations
 	std::vector<double> tmpVelVector(3, 0);
@@ -368,16 +940,16 @@ void GridObj::_LBM_regularised_opt(int i, int j, int k, int id, eType type, int
 		for (int v = 0; v < L_NUM_VELS; ++v)
 		{
 			// If has opposite normal direction component then part of f_plus
-			if (c_opt[v][normalDirection] == -normalVector[normalDirection])
+			if (Lattice::c[v][normalDirection] == -normalVector[normalDirection])
 			{
 				// Add to known momentum leaving the domain
-				f_plus += fNew[v + id * L_NUM_VELS];
+				f_plus += f_local[v];
 
 			}
 			// If it is perpendicular to wall part of f_zero
-			else if (c_opt[v][normalDirection] == 0)
+			else if (Lattice::c[v][normalDirection] == 0)
 			{
-				f_zero += fNew[v + id * L_NUM_VELS];
+				f_zero += f_local[v];
 			}
 		}
 
@@ -430,18 +1002,18 @@ void GridObj::_LBM_regularised_opt(int i, int j, int k, int id, eType type, int
 		// Apply off-equilibrium BB to unknown components //
 
 		// Unknowns for a normal case share the normal vector components
-		if (edgeCount == 1 && c_opt[v][normalDirection] == normalVector[normalDirection])
+		if (edgeCount == 1 && Lattice::c[v][normalDirection] == normalVector[normalDirection])
 		{
-			fNew[v + id * L_NUM_VELS] = _LBM_equilibrium_opt(id, v) +
-				(fNew[GridUtils::getOpposite(v) + id * L_NUM_VELS] - _LBM_equilibrium_opt(id, GridUtils::getOpposite(v)));
+			f_local[v] = _LBM_equilibrium_opt(id, v) +
+				(f_local[GridUtils::getOpposite(v)] - _LBM_equilibrium_opt(id, GridUtils::getOpposite(v)));
 		}
 
 		// Unknown in edge cases are ones who share at least one of the normal components
 		else if (edgeCount > 1 && (
-			c_opt[v][eXDirection] == normalVector[eXDirection] ||
-			c_opt[v][eYDirection] == normalVector[eYDirection]
+			Lattice::c[v][eXDirection] == normalVector[eXDirection] ||
+			Lattice::c[v][eYDirection] == normalVector[eYDirection]
 #if (L_DIMS == 3)
-			|| c_opt[v][eZDirection] == normalVector[eZDirection]
+			|| Lattice::c[v][eZDirection] == normalVector[eZDirection]
 #endif
 			)
 			)
@@ -451,35 +1023,35 @@ void GridObj::_LBM_regularised_opt(int i, int j, int k, int id, eType type, int
 			double mag = 0.0;
 			for (int d = 0; d < L_DIMS; d++)
 			{
-				dp += c_opt[v][d] * normalVector[d];
-				mag += (static_cast<double>(c_opt[v][d]) * static_cast<double>(c_opt[v][d]));
+				dp += Lattice::c[v][d] * normalVector[d];
+				mag += (static_cast<double>(Lattice::c[v][d]) * static_cast<double>(Lattice::c[v][d]));
 			}
 			mag = sqrt(mag);
 
 			// If a buried link then set to feq (plane with normal parallel to normal of boundary)
 			if (dp == 0 && mag > 1.0)
 			{
-				fNew[v + id * L_NUM_VELS] = _LBM_equilibrium_opt(id, v);
+				f_local[v] = _LBM_equilibrium_opt(id, v);
 			}
 			// Else apply non-equilbrium bounceback
 			else
 			{
-				fNew[v + id * L_NUM_VELS] = _LBM_equilibrium_opt(id, v) +
-					(fNew[GridUtils::getOpposite(v) + id * L_NUM_VELS] - _LBM_equilibrium_opt(id, GridUtils::getOpposite(v)));
+				f_local[v] = _LBM_equilibrium_opt(id, v) +
+					(f_local[GridUtils::getOpposite(v)] - _LBM_equilibrium_opt(id, GridUtils::getOpposite(v)));
 			}
 		}
 
 		// Store off-equilibrium and update stress components
-		fneq = fNew[v + id * L_NUM_VELS] - _LBM_equilibrium_opt(id, v);
+		fneq = f_local[v] - _LBM_equilibrium_opt(id, v);
 
 		// Compute off-equilibrium stress components
-		Sxx += c_opt[v][eXDirection] * c_opt[v][eXDirection] * fneq;
-		Syy += c_opt[v][eYDirection] * c_opt[v][eYDirection] * fneq;
-		Sxy += c_opt[v][eXDirection] * c_opt[v][eYDirection] * fneq;
+		Sxx += Lattice::c[v][eXDirection] * Lattice::c[v][eXDirection] * fneq;
+		Syy += Lattice::c[v][eYDirection] * Lattice::c[v][eYDirection] * fneq;
+		Sxy += Lattice::c[v][eXDirection] * Lattice::c[v][eYDirection] * fneq;
 #if (L_DIMS == 3)
-		Szz += c_opt[v][eZDirection] * c_opt[v][eZDirection] * fneq;
-		Sxz += c_opt[v][eXDirection] * c_opt[v][eZDirection] * fneq;
-		Syz += c_opt[v][eYDirection] * c_opt[v][eZDirection] * fneq;
+		Szz += Lattice::c[v][eZDirection] * Lattice::c[v][eZDirection] * fneq;
+		Sxz += Lattice::c[v][eXDirection] * Lattice::c[v][eZDirection] * fneq;
+		Syz += Lattice::c[v][eYDirection] * Lattice::c[v][eZDirection] * fneq;
 #endif
 
 	}
@@ -487,15 +1059,15 @@ void GridObj::_LBM_regularised_opt(int i, int j, int k, int id, eType type, int
 	// Compute regularised non-equilibrium components and add to feq to get new populations
 	for (int v = 0; v < L_NUM_VELS; v++)
 	{
-		fNew[v + id * L_NUM_VELS] = _LBM_equilibrium_opt(id, v) +
-			(w[v] / (2.0 * SQ(cs) * SQ(cs))) *
+		f_local[v] = _LBM_equilibrium_opt(id, v) +
+			(Lattice::w[v] / (2.0 * SQ(cs) * SQ(cs))) *
 			(
-			((c_opt[v][eXDirection] * c_opt[v][eXDirection] - SQ(cs)) * Sxx) +
-			((c_opt[v][eYDirection] * c_opt[v][eYDirection] - SQ(cs)) * Syy) +
-			((c_opt[v][eZDirection] * c_opt[v][eZDirection] - SQ(cs)) * Szz) +
-			(2.0 * c_opt[v][eXDirection] * c_opt[v][eYDirection] * Sxy) +
-			(2.0 * c_opt[v][eXDirection] * c_opt[v][eZDirection] * Sxz) +
-			(2.0 * c_opt[v][eYDirection] * c_opt[v][eZDirection] * Syz)
+			((Lattice::c[v][eXDirection] * Lattice::c[v][eXDirection] - SQ(cs)) * Sxx) +
+			((Lattice::c[v][eYDirection] * Lattice::c[v][eYDirection] - SQ(cs)) * Syy) +
+			((Lattice::c[v][eZDirection] * Lattice::c[v][eZDirection] - SQ(cs)) * Szz) +
+			(2.0 * Lattice::c[v][eXDirection] * Lattice::c[v][eYDirection] * Sxy) +
+			(2.0 * Lattice::c[v][eXDirection] * Lattice::c[v][eZDirection] * Sxz) +
+			(2.0 * Lattice::c[v][eYDirection] * Lattice::c[v][eZDirection] * Syz)
 			);
 	}
 
@@ -514,9 +1086,10 @@ void GridObj::_LBM_regularised_opt(int i, int j, int k, int id, eType type, int
 ///	\param	k		z index.
 /// \param	id		flattened ijk index.
 /// \param	v		velocity direction.
+///	\param	f_local	populations of the current site being streamed.
 ///	\returns		indication whether specular reflection was applied on this 
 ///					direction.
-bool GridObj::_LBM_applySpecReflect_opt(int i, int j, int k, int id, int v)
+bool GridObj::_LBM_applySpecReflect_opt(int i, int j, int k, int id, int v, double *f_local)
 {
 
 	// Get inward normal information
@@ -524,44 +1097,44 @@ bool GridObj::_LBM_applySpecReflect_opt(int i, int j, int k, int id, int v)
 	if (GridUtils::isWithinDomainWall(XPos[i], YPos[j], ZPos[k], &normVec))
 	{
 		// Left slip
-		if (normVec[eXDirection] == 1 && c_opt[v][eXDirection] == 1)
+		if (normVec[eXDirection] == 1 && Lattice::c[v][eXDirection] == 1)
 		{
-			fNew[v + id * L_NUM_VELS] = f[GridUtils::getReflect(v, eXDirection) + id * L_NUM_VELS];
+			f_local[v] = f[LBM_popIdx(id, GridUtils::getReflect(v, eXDirection))];
 			return true;
 		}
 
 		// Right slip
-		if (normVec[eXDirection] == -1 && c_opt[v][eXDirection] == -1)
+		if (normVec[eXDirection] == -1 && Lattice::c[v][eXDirection] == -1)
 		{
-			fNew[v + id * L_NUM_VELS] = f[GridUtils::getReflect(v, eXDirection) + id * L_NUM_VELS];
+			f_local[v] = f[LBM_popIdx(id, GridUtils::getReflect(v, eXDirection))];
 			return true;
 		}
 
 		// Bottom slip
-		if (normVec[eYDirection] == 1 && c_opt[v][eYDirection] == 1)
+		if (normVec[eYDirection] == 1 && Lattice::c[v][eYDirection] == 1)
 		{
-			fNew[v + id * L_NUM_VELS] = f[GridUtils::getReflect(v, eYDirection) + id * L_NUM_VELS];
+			f_local[v] = f[LBM_popIdx(id, GridUtils::getReflect(v, eYDirection))];
 			return true;
 		}
 
 		// Top slip
-		if (normVec[eYDirection] == -1 && c_opt[v][eYDirection] == -1)
+		if (normVec[eYDirection] == -1 && Lattice::c[v][eYDirection] == -1)
 		{
-			fNew[v + id * L_NUM_VELS] = f[GridUtils::getReflect(v, eYDirection) + id * L_NUM_VELS];
+			f_local[v] = f[LBM_popIdx(id, GridUtils::getReflect(v, eYDirection))];
 			return true;
 		}
 
 		// Front slip
-		if (normVec[eZDirection] == 1 && c_opt[v][eZDirection] == 1)
+		if (normVec[eZDirection] == 1 && Lattice::c[v][eZDirection] == 1)
 		{
-			fNew[v + id * L_NUM_VELS] = f[GridUtils::getReflect(v, eZDirection) + id * L_NUM_VELS];
+			f_local[v] = f[LBM_popIdx(id, GridUtils::getReflect(v, eZDirection))];
 			return true;
 		}
 
 		// Back slip
-		if (normVec[eZDirection] == -1 && c_opt[v][eZDirection] == -1)
+		if (normVec[eZDirection] == -1 && Lattice::c[v][eZDirection] == -1)
 		{
-			fNew[v + id * L_NUM_VELS] = f[GridUtils::getReflect(v, eZDirection) + id * L_NUM_VELS];
+			f_local[v] = f[LBM_popIdx(id, GridUtils::getReflect(v, eZDirection))];
 			return true;
 		}
 
@@ -580,22 +1153,15 @@ bool GridObj::_LBM_applySpecReflect_opt(int i, int j, int k, int id, int v)
 /// \param	k	z-index of current site.
 ///	\param	id	flattened ijk index.
 /// \param	v	lattice direction.
-void GridObj::_LBM_coalesce_opt(int i, int j, int k, int id, int v) {
+/// \return		population streamed from the child grid.
+double GridObj::_LBM_coalesce_opt(int i, int j, int k, int id, int v) {
 
 	// Get pointer to appropriate child grid
-	GridObj *childGrid = GridUtils::getSubGrid(i, j, k, this);
-	if (!childGrid) L_ERROR("Could not get correct grid for coalesce operation.", GridUtils::logfile);
+	if (subGridIdx[id] < 0) L_ERROR("Could not get correct grid for coalesce operation.", GridUtils::logfile);
+	GridObj *childGrid = subGrid[subGridIdx[id]];
 
-	// Get sizes
-	int cM_lim = childGrid->M_lim;
-	int cK_lim = childGrid->K_lim;
-
-	// Get indices of child site
-	std::vector<int> cInd =
-		GridUtils::getFineIndices(
-		i, childGrid->CoarseLimsX[eMinimum],
-		j, childGrid->CoarseLimsY[eMinimum],
-		k, childGrid->CoarseLimsZ[eMinimum]);
+	// Get indices of first child site
+	const int cInd[3] = { childGrid->fineIdxX[i], childGrid->fineIdxY[j], childGrid->fineIdxZ[k] };
 
 	// Pull average value of f from child cluster
 	double fNew_local = 0.0;
@@ -608,10 +1174,7 @@ void GridObj::_LBM_coalesce_opt(int i, int j, int k, int id, int v) {
 #endif
 			{
 				fNew_local +=
-					childGrid->f[v +
-					(cInd[2] + kk) * L_NUM_VELS +
-					(cInd[1] + jj) * L_NUM_VELS * cK_lim +
-					(cInd[0] + ii) * L_NUM_VELS * cK_lim * cM_lim];
+					childGrid->f[childGrid->LBM_fIdx(cInd[0] + ii, cInd[1] + jj, cInd[2] + kk, v)];
 			}
 		}
 	}
@@ -622,8 +1185,7 @@ void GridObj::_LBM_coalesce_opt(int i, int j, int k, int id, int v) {
 	fNew_local /= 4.0;
 #endif
 
-	// Store back in memory
-	fNew[v + id * L_NUM_VELS] = fNew_local;
+	return fNew_local;
 
 }
 
@@ -635,23 +1197,11 @@ void GridObj::_LBM_coalesce_opt(int i, int j, int k, int id, int v) {
 ///	\param	src_x	x-index of site where value is pulled from.
 ///	\param	src_y	y-index of site where value is pulled from.
 ///	\param	src_z	z-index of site where value is pulled from.
-void GridObj::_LBM_explode_opt(int id, int v, int src_x, int src_y, int src_z) {
-
-	// Get parent indices
-	std::vector<int> pInd =
-		GridUtils::getCoarseIndices(
-		src_x, CoarseLimsX[eMinimum],
-		src_y, CoarseLimsY[eMinimum],
-		src_z, CoarseLimsZ[eMinimum]);
+/// \return			population streamed from the parent grid.
+double GridObj::_LBM_explode_opt(int id, int v, int src_x, int src_y, int src_z) {
 
 	// Pull value from parent
-	fNew[v + id * L_NUM_VELS] =
-		parentGrid->f[
-			v +
-				pInd[2] * L_NUM_VELS +
-				pInd[1] * L_NUM_VELS * parentGrid->K_lim +
-				pInd[0] * L_NUM_VELS * parentGrid->K_lim * parentGrid->M_lim
-		];
+	return parentGrid->f[parentGrid->LBM_fIdx(coarseIdxX[src_x], coarseIdxY[src_y], coarseIdxZ[src_z], v)];
 }
 
 // *****************************************************************************
@@ -671,28 +1221,79 @@ double GridObj::_LBM_equilibrium_opt(int id, int v) {
 	// Compute the parts of the expansion for feq
 
 #if (L_DIMS == 3)
-	A = (c_opt[v][0] * u[0 + id * L_DIMS]) +
-		(c_opt[v][1] * u[1 + id * L_DIMS]) +
-		(c_opt[v][2] * u[2 + id * L_DIMS]);
-
-	B = (SQ(c_opt[v][0]) - SQ(cs)) * SQ(u[0 + id * L_DIMS]) +
-		(SQ(c_opt[v][1]) - SQ(cs)) * SQ(u[1 + id * L_DIMS]) +
-		(SQ(c_opt[v][2]) - SQ(cs)) * SQ(u[2 + id * L_DIMS]) +
-		2 * c_opt[v][0] * c_opt[v][1] * u[0 + id * L_DIMS] * u[1 + id * L_DIMS] +
-		2 * c_opt[v][0] * c_opt[v][2] * u[0 + id * L_DIMS] * u[2 + id * L_DIMS] +
-		2 * c_opt[v][1] * c_opt[v][2] * u[1 + id * L_DIMS] * u[2 + id * L_DIMS];
+	A = (Lattice::c[v][0] * u[0 + id * L_DIMS]) +
+		(Lattice::c[v][1] * u[1 + id * L_DIMS]) +
+		(Lattice::c[v][2] * u[2 + id * L_DIMS]);
+
+	B = (SQ(Lattice::c[v][0]) - SQ(cs)) * SQ(u[0 + id * L_DIMS]) +
+		(SQ(Lattice::c[v][1]) - SQ(cs)) * SQ(u[1 + id * L_DIMS]) +
+		(SQ(Lattice::c[v][2]) - SQ(cs)) * SQ(u[2 + id * L_DIMS]) +
+		2 * Lattice::c[v][0] * Lattice::c[v][1] * u[0 + id * L_DIMS] * u[1 + id * L_DIMS] +
+		2 * Lattice::c[v][0] * Lattice::c[v][2] * u[0 + id * L_DIMS] * u[2 + id * L_DIMS] +
+		2 * Lattice::c[v][1] * Lattice::c[v][2] * u[1 + id * L_DIMS] * u[2 + id * L_DIMS];
 #else
-	A = (c_opt[v][0] * u[0 + id * L_DIMS]) +
-		(c_opt[v][1] * u[1 + id * L_DIMS]);
+	A = (Lattice::c[v][0] * u[0 + id * L_DIMS]) +
+		(Lattice::c[v][1] * u[1 + id * L_DIMS]);
 
-	B = (SQ(c_opt[v][0]) - SQ(cs)) * SQ(u[0 + id * L_DIMS]) +
-		(SQ(c_opt[v][1]) - SQ(cs)) * SQ(u[1 + id * L_DIMS]) +
-		2 * c_opt[v][0] * c_opt[v][1] * u[0 + id * L_DIMS] * u[1 + id * L_DIMS];
+	B = (SQ(Lattice::c[v][0]) - SQ(cs)) * SQ(u[0 + id * L_DIMS]) +
+		(SQ(Lattice::c[v][1]) - SQ(cs)) * SQ(u[1 + id * L_DIMS]) +
+		2 * Lattice::c[v][0] * Lattice::c[v][1] * u[0 + id * L_DIMS] * u[1 + id * L_DIMS];
 #endif
 
 
 	// Compute f^eq
-	return rho[id] * w[v] * ( 1.0 + (A / SQ(cs)) + (B / (2.0 * SQ(cs)*SQ(cs)) ) );
+	return rho[id] * Lattice::w[v] * ( 1.0 + (A / SQ(cs)) + (B / (2.0 * SQ(cs)*SQ(cs)) ) );
+
+}
+
+// *****************************************************************************
+/// \brief	Compute the equilibrium populations of a site in all directions.
+///
+///			The directions are computed together from the supplied moments so 
+///			the loop can be vectorised. Gives identical results to calling 
+///			_LBM_equilibrium_opt for each direction.
+///
+///	\param	rho_local	density of the site.
+///	\param	u_local		velocity of the site.
+///	\param	feq_local	array to hold the equilibrium populations.
+void GridObj::_LBM_equilibria_opt(double rho_local, const double *u_local, double *feq_local) {
+
+	// Velocity components
+	const double ux = u_local[0];
+	const double uy = u_local[1];
+#if (L_DIMS == 3)
+	const double uz = u_local[2];
+#endif
+
+#ifdef L_ENABLE_OPENMP
+#pragma omp simd
+#endif
+	for (int v = 0; v < L_NUM_VELS; ++v)
+	{
+		// Compute the parts of the expansion for feq
+#if (L_DIMS == 3)
+		double A = (Lattice::c[v][0] * ux) +
+			(Lattice::c[v][1] * uy) +
+			(Lattice::c[v][2] * uz);
+
+		double B = (SQ(Lattice::c[v][0]) - SQ(cs)) * SQ(ux) +
+			(SQ(Lattice::c[v][1]) - SQ(cs)) * SQ(uy) +
+			(SQ(Lattice::c[v][2]) - SQ(cs)) * SQ(uz) +
+			2 * Lattice::c[v][0] * Lattice::c[v][1] * ux * uy +
+			2 * Lattice::c[v][0] * Lattice::c[v][2] * ux * uz +
+			2 * Lattice::c[v][1] * Lattice::c[v][2] * uy * uz;
+#else
+		double A = (Lattice::c[v][0] * ux) +
+			(Lattice::c[v][1] * uy);
+
+		double B = (SQ(Lattice::c[v][0]) - SQ(cs)) * SQ(ux) +
+			(SQ(Lattice::c[v][1]) - SQ(cs)) * SQ(uy) +
+			2 * Lattice::c[v][0] * Lattice::c[v][1] * ux * uy;
+#endif
+
+		// Compute f^eq
+		feq_local[v] = rho_local * Lattice::w[v] * (1.0 + (A / SQ(cs)) + (B / (2.0 * SQ(cs)*SQ(cs))));
+	}
 
 }
 
@@ -703,43 +1304,45 @@ double GridObj::_LBM_equilibrium_opt(int id, int v) {
 ///			and without frame rotation using lattice Boltzmann method" by Yu, 
 ///			Huidan Girimaji, Sharath S. Luo, Li Shi  [2005]
 ///
-///	\param	id 		flattened ijk index. 
 /// \param 	omega 	Relaxation frequency. 
+///	\param	f_local	streamed populations of the site.
+///	\param	feq_local	equilibrium populations of the site.
 /// \return 		Smagorinsky-modified omega value
-double GridObj::_LBM_smag(int id, double omega)
+double GridObj::_LBM_smag(double omega, const double *f_local, const double *feq_local)
 {
-	// Calculate the non equilibrium stress tensor
-	Matrix2D<double> nonEquiStress(3,3);
-	double fneq[L_NUM_VELS];
- 
-	// Compute non-equilibrium values
-	for (int v = 0; v < L_NUM_VELS; ++v)
-		fneq[v] = fNew[v + id*L_NUM_VELS] - _LBM_equilibrium_opt(id, v);
-
-	// Calculate diagonal and upper diagonal of the non equilibrium stress tensor
-	for (int i = 0; i < L_DIMS; ++i)
-	{
-		for (int j = i; j < L_DIMS; ++j)
-		{
-			nonEquiStress[i][j] = 0.0;
-			for (int v = 0; v < L_NUM_VELS; ++v)
-			{
-				nonEquiStress[i][j] += c_opt[v][i] * c_opt[v][j] * fneq[v];
-			}
-		}
-	}
+	// Non-equilibrium stress tensor (upper triangle only as it is symmetric)
+	double Pxx = 0.0, Pxy = 0.0, Pyy = 0.0;
+#if (L_DIMS == 3)
+	double Pxz = 0.0, Pyz = 0.0, Pzz = 0.0;
+#endif
 
-	// Fill in the lower diagonal of the non equilibrium stress tensor (since this tensor is symmetric)
-	for (int i = 1; i < L_DIMS; ++i)
+	// Accumulate all components in a single pass over the populations
+	for (int v = 0; v < L_NUM_VELS; ++v)
 	{
-		for (int j = 0; j < i; ++j)
-		{
-			nonEquiStress[i][j] = nonEquiStress[j][i];
-		}
+		double fneq = f_local[v] - feq_local[v];
+		Pxx += Lattice::c[v][0] * Lattice::c[v][0] * fneq;
+		Pxy += Lattice::c[v][0] * Lattice::c[v][1] * fneq;
+		Pyy += Lattice::c[v][1] * Lattice::c[v][1] * fneq;
+#if (L_DIMS == 3)
+		Pxz += Lattice::c[v][0] * Lattice::c[v][2] * fneq;
+		Pyz += Lattice::c[v][1] * Lattice::c[v][2] * fneq;
+		Pzz += Lattice::c[v][2] * Lattice::c[v][2] * fneq;
+#endif
 	}
 
-	// Inner product
-	double Q = sqrt(2.0 * (nonEquiStress % nonEquiStress));
+	// Inner product (summed row by row)
+#if (L_DIMS == 3)
+	double Q = sqrt(2.0 * (
+		(SQ(Pxx) + SQ(Pxy) + SQ(Pxz)) +
+		(SQ(Pxy) + SQ(Pyy) + SQ(Pyz)) +
+		(SQ(Pxz) + SQ(Pyz) + SQ(Pzz))
+		));
+#else
+	double Q = sqrt(2.0 * (
+		(SQ(Pxx) + SQ(Pxy)) +
+		(SQ(Pxy) + SQ(Pyy))
+		));
+#endif
 
 	// Compute tau correction
 	double tau = 1.0 / omega;
@@ -754,42 +1357,219 @@ double GridObj::_LBM_smag(int id, double omega)
 ///			value of omega locally.
 ///
 /// \param	id	flattened ijk index.
-void GridObj::_LBM_collide_opt(int id)
+///	\param	f_local	streamed populations of the site which are collided in place.
+///	\param	rho_local	density of the site.
+///	\param	u_local		velocity of the site.
+void GridObj::_LBM_collide_opt(int id, double *f_local, double rho_local, const double *u_local)
 {
+	// Equilibrium populations (shared by Smagorinsky and the collision)
+	double feq_local[L_NUM_VELS];
+	_LBM_equilibria_opt(rho_local, u_local, feq_local);
 
 #ifdef L_USE_BGKSMAG
 	// Compute Smagorinksy-modified relaxation
-	double omega_s = _LBM_smag(id, omega);
+	double omega_s = _LBM_smag(omega, f_local, feq_local);
 #else
 	double omega_s = omega;
 #endif
 
 	// Perform collision operation (using omega_s -- modified if using Smagorinksy)
+#ifdef L_ENABLE_OPENMP
+#pragma omp simd
+#endif
 	for (int v = 0; v < L_NUM_VELS; ++v)
 	{
-		fNew[v + id * L_NUM_VELS] +=
+		f_local[v] +=
 			omega_s *	(
-			_LBM_equilibrium_opt(id, v) -
-			fNew[v + id * L_NUM_VELS]
+			feq_local[v] -
+			f_local[v]
 			)
 
 #if (defined L_GRAVITY_ON || defined L_IBM_ON)
-			+ force_i[v + id * L_NUM_VELS]
+			+ force_i[LBM_popIdx(id, v)]
 #endif
 			;
 	}
 
 }
 
+#ifdef L_COLLIDE_BATCH
+// *****************************************************************************
+/// \brief	Collide and store the sites held in a batch.
+///
+///			Same operations as _LBM_collide_opt but each direction is computed
+///			for all the sites of the batch at once, so the loops are vectorised
+///			across the sites. Gives identical results to colliding the sites
+///			one by one. The batch is empty afterwards.
+///
+///	\param	batch	sites to be collided.
+void GridObj::_LBM_collideBatch_opt(CollideBatch &batch)
+{
+	const int n = batch.size;
+	const int *id = batch.site[3];
+
+	// Equilibrium populations (shared by Smagorinsky and the collision)
+	double feq_b[L_NUM_VELS][L_COLLIDE_BATCH];
+	for (int v = 0; v < L_NUM_VELS; ++v)
+	{
+#ifdef L_ENABLE_OPENMP
+#pragma omp simd
+#endif
+		for (int s = 0; s < n; ++s)
+		{
+			const double ux = batch.u[0][s];
+			const double uy = batch.u[1][s];
+#if (L_DIMS == 3)
+			const double uz = batch.u[2][s];
+
+			double A = (Lattice::c[v][0] * ux) +
+				(Lattice::c[v][1] * uy) +
+				(Lattice::c[v][2] * uz);
+
+			double B = (SQ(Lattice::c[v][0]) - SQ(cs)) * SQ(ux) +
+				(SQ(Lattice::c[v][1]) - SQ(cs)) * SQ(uy) +
+				(SQ(Lattice::c[v][2]) - SQ(cs)) * SQ(uz) +
+				2 * Lattice::c[v][0] * Lattice::c[v][1] * ux * uy +
+				2 * Lattice::c[v][0] * Lattice::c[v][2] * ux * uz +
+				2 * Lattice::c[v][1] * Lattice::c[v][2] * uy * uz;
+#else
+			double A = (Lattice::c[v][0] * ux) +
+				(Lattice::c[v][1] * uy);
+
+			double B = (SQ(Lattice::c[v][0]) - SQ(cs)) * SQ(ux) +
+				(SQ(Lattice::c[v][1]) - SQ(cs)) * SQ(uy) +
+				2 * Lattice::c[v][0] * Lattice::c[v][1] * ux * uy;
+#endif
+
+			feq_b[v][s] = batch.rho[s] * Lattice::w[v] * (1.0 + (A / SQ(cs)) + (B / (2.0 * SQ(cs)*SQ(cs))));
+		}
+	}
+
+	// Relaxation frequency of each site
+	double omega_b[L_COLLIDE_BATCH];
+#ifdef L_USE_BGKSMAG
+	{
+		// Non-equilibrium stress tensor accumulated in the same order as _LBM_smag
+		double Pxx[L_COLLIDE_BATCH] = {}, Pxy[L_COLLIDE_BATCH] = {}, Pyy[L_COLLIDE_BATCH] = {};
+#if (L_DIMS == 3)
+		double Pxz[L_COLLIDE_BATCH] = {}, Pyz[L_COLLIDE_BATCH] = {}, Pzz[L_COLLIDE_BATCH] = {};
+#endif
+		for (int v = 0; v < L_NUM_VELS; ++v)
+		{
+#ifdef L_ENABLE_OPENMP
+#pragma omp simd
+#endif
+			for (int s = 0; s < n; ++s)
+			{
+				double fneq = batch.f[v][s] - feq_b[v][s];
+				Pxx[s] += Lattice::c[v][0] * Lattice::c[v][0] * fneq;
+				Pxy[s] += Lattice::c[v][0] * Lattice::c[v][1] * fneq;
+				Pyy[s] += Lattice::c[v][1] * Lattice::c[v][1] * fneq;
+#if (L_DIMS == 3)
+				Pxz[s] += Lattice::c[v][0] * Lattice::c[v][2] * fneq;
+				Pyz[s] += Lattice::c[v][1] * Lattice::c[v][2] * fneq;
+				Pzz[s] += Lattice::c[v][2] * Lattice::c[v][2] * fneq;
+#endif
+			}
+		}
+
+#ifdef L_ENABLE_OPENMP
+#pragma omp simd
+#endif
+		for (int s = 0; s < n; ++s)
+		{
+#if (L_DIMS == 3)
+			double Q = sqrt(2.0 * (
+				(SQ(Pxx[s]) + SQ(Pxy[s]) + SQ(Pxz[s])) +
+				(SQ(Pxy[s]) + SQ(Pyy[s]) + SQ(Pyz[s])) +
+				(SQ(Pxz[s]) + SQ(Pyz[s]) + SQ(Pzz[s]))
+				));
+#else
+			double Q = sqrt(2.0 * (
+				(SQ(Pxx[s]) + SQ(Pxy[s])) +
+				(SQ(Pxy[s]) + SQ(Pyy[s]))
+				));
+#endif
+			double tau = 1.0 / omega;
+			double tau_t = 0.5 * (sqrt(SQ(tau) + 2.0 * L_SQRT2 * SQ(L_CSMAG) * L_RHOIN * SQ(cs) * SQ(cs) * Q ) - tau);
+			omega_b[s] = 1.0 / (tau + tau_t);
+		}
+	}
+#else
+	for (int s = 0; s < n; ++s)
+		omega_b[s] = omega;
+#endif
+
+	// Perform collision operation
+	for (int v = 0; v < L_NUM_VELS; ++v)
+	{
+#ifdef L_ENABLE_OPENMP
+#pragma omp simd
+#endif
+		for (int s = 0; s < n; ++s)
+		{
+			batch.f[v][s] +=
+				omega_b[s] * (
+				feq_b[v][s] -
+				batch.f[v][s]
+				)
+
+#if (defined L_GRAVITY_ON || defined L_IBM_ON)
+				+ force_i[LBM_popIdx(id[s], v)]
+#endif
+				;
+		}
+	}
+
+	// Write populations back for the next time step
+	for (int s = 0; s < n; ++s)
+	{
+		double f_local[L_NUM_VELS];
+		for (int v = 0; v < L_NUM_VELS; ++v)
+			f_local[v] = batch.f[v][s];
+		_LBM_storeCollided_opt(batch.site[0][s], batch.site[1][s], batch.site[2][s], id[s], f_local);
+	}
+	batch.size = 0;
+}
+#endif
+
 // *****************************************************************************
 /// \brief	Optimised macroscopic operation.
 ///
+///			Computes and stores the macroscopic quantities of a site.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+/// \param	id	flattened ijk index.
+///	\param	type_local	type of site under consideration
+///	\param	f_local	streamed populations of the site.
+void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local, double *f_local) {
+
+	double rho_local, u_local[L_DIMS];
+	_LBM_macro_opt(i, j, k, id, type_local, f_local, rho_local, u_local, true);
+
+}
+
+// *****************************************************************************
+/// \brief	Optimised macroscopic operation returning the moments.
+///
+///			The moments are returned in registers for the collision. They are 
+///			only written back to the grid arrays if requested, which is needed 
+///			for output, restart, probes, IBM and the sub-grid coupling. Sites 
+///			which are not updated return the values already held by the grid.
+///
 /// \param	i	x-index of current site.
 /// \param	j	y-index of current site.
 /// \param	k	z-index of current site.
 /// \param	id	flattened ijk index.
 ///	\param	type_local	type of site under consideration
-void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local) {
+///	\param	f_local	streamed populations of the site.
+///	\param	rho_local	density of the site.
+///	\param	u_local		velocity of the site.
+///	\param	bStore		flag to write the moments back to the grid arrays.
+void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local, double *f_local,
+							 double &rho_local, double *u_local, bool bStore) {
 
 	// Only update fluid sites (including BFL and Slip) or TL to finer
 	if (type_local == eFluid || type_local == eBFL ||
@@ -809,11 +1589,11 @@ void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local) {
 		// Sum to find rho and momentum
 		for (int v = 0; v < L_NUM_VELS; ++v)
 		{
-			rho_temp += fNew[v + id * L_NUM_VELS];
-			rhouX_temp += c_opt[v][0] * fNew[v + id * L_NUM_VELS];
-			rhouY_temp += c_opt[v][1] * fNew[v + id * L_NUM_VELS];
+			rho_temp += f_local[v];
+			rhouX_temp += Lattice::c[v][0] * f_local[v];
+			rhouY_temp += Lattice::c[v][1] * f_local[v];
 #if (L_DIMS == 3)
-			rhouZ_temp += c_opt[v][2] * fNew[v + id * L_NUM_VELS];
+			rhouZ_temp += Lattice::c[v][2] * f_local[v];
 #endif
 		}
 
@@ -827,29 +1607,41 @@ void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local) {
 #endif
 
 		// Divide by rho to get velocity
-		u[0 + id * L_DIMS] = rhouX_temp / rho_temp;
-		u[1 + id * L_DIMS] = rhouY_temp / rho_temp;
+		u_local[0] = rhouX_temp / rho_temp;
+		u_local[1] = rhouY_temp / rho_temp;
 #if (L_DIMS == 3)
-		u[2 + id * L_DIMS] = rhouZ_temp / rho_temp;
+		u_local[2] = rhouZ_temp / rho_temp;
 #endif
 
 		// Assign density
-		rho[id] = rho_temp;
+		rho_local = rho_temp;
+
+		// Write back to the grid
+		if (bStore)
+		{
+			for (int d = 0; d < L_DIMS; ++d)
+				u[d + id * L_DIMS] = u_local[d];
+			rho[id] = rho_local;
+		}
 
 	}
+	else
+	{
+		// Use stored values
+		for (int d = 0; d < L_DIMS; ++d)
+			u_local[d] = u[d + id * L_DIMS];
+		rho_local = rho[id];
+	}
 
-	// Update child TL sites for aethetic reasons only -- can be removed for performance
-	if (type_local == eTransitionToFiner) {
+	// Update child TL sites for aethetic reasons only -- can be removed for performance.
+	// Each TL site owns a separate block of child sites so threads never write the same ones.
+	if (bStore && type_local == eTransitionToFiner) {
 
 		// Get child grid
-		GridObj *childGrid = GridUtils::getSubGrid(i, j, k, this);
+		GridObj *childGrid = subGrid[subGridIdx[id]];
 
 		// Get indices
-		std::vector<int> cInd =
-			GridUtils::getFineIndices(
-			i, childGrid->CoarseLimsX[eMinimum],
-			j, childGrid->CoarseLimsY[eMinimum],
-			k, childGrid->CoarseLimsZ[eMinimum]);
+		const int cInd[3] = { childGrid->fineIdxX[i], childGrid->fineIdxY[j], childGrid->fineIdxZ[k] };
 
 		// Get sizes
 		int cM_lim = childGrid->M_lim;
@@ -869,26 +1661,37 @@ void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local) {
 								(cInd[2] + kk) * L_DIMS +
 								(cInd[1] + jj) * L_DIMS * cK_lim +
 								(cInd[0] + ii) * L_DIMS * cK_lim * cM_lim
-						] = u[d + id * L_DIMS];
+						] = u_local[d];
 					}
 
 					childGrid->rho[
 						(cInd[2] + kk) +
 							(cInd[1] + jj) * cK_lim +
 							(cInd[0] + ii) * cK_lim * cM_lim
-					] = rho[id];
+					] = rho_local;
 				}
 			}
 		}
 	}
 
-	// TIME-AVERAGED QUANTITIES //
+}
 
-#ifdef L_COMPUTE_TIME_AVERAGED_QUANTITIES
+// *****************************************************************************
+/// \brief	Update the time-averaged quantities of a site.
+///
+///			Called once per site per time step by the kernel. Kept separate from 
+///			the macroscopic update as that may also be used to update sites out 
+///			of turn (e.g. by the regularised BCs or IBM).
+///
+/// \param	id			flattened ijk index.
+///	\param	rho_local	density of the site.
+///	\param	u_local		velocity of the site.
+void GridObj::_LBM_timeAverage_opt(int id, double rho_local, const double *u_local)
+{
 	// Multiply current value by completed time steps to get sum
 	double ta_temp = rho_timeav[id] * (double)t;
 	// Add new value
-	ta_temp += rho[id];
+	ta_temp += rho_local;
 	// Divide by completed time steps + 1 to get new average
 	rho_timeav[id] = ta_temp / (double)(t + 1);
 
@@ -896,18 +1699,52 @@ void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local) {
 	int pq_combo = 0;
 	for (int p = 0; p < L_DIMS; p++) {
 		ta_temp = ui_timeav[p + id * L_DIMS] * (double)t;
-		ta_temp += u[p + id * L_DIMS];
+		ta_temp += u_local[p];
 		ui_timeav[p + id * L_DIMS] = ta_temp / (double)(t + 1);
 		// Do necessary products
 		for (int q = p; q < L_DIMS; q++) {
 			ta_temp = uiuj_timeav[pq_combo + id * (3 * L_DIMS - 3)] * (double)t;
-			ta_temp += (u[p + id * L_DIMS] * u[q + id * L_DIMS]);
+			ta_temp += (u_local[p] * u_local[q]);
 			uiuj_timeav[pq_combo + id * (3 * L_DIMS - 3)] = ta_temp / (double)(t + 1);
 			pq_combo++;
 		}
 	}
-#endif
+}
+
+// *****************************************************************************
+/// \brief	Decide whether the current time step must store macroscopic quantities.
+///
+///			Without IBM, regularised boundaries or KBC the velocity and density 
+///			are only used by the collision of the same site so are kept in 
+///			registers. They only need writing back to the grid on steps which 
+///			complete an L0 step that is written out, probed or restarted from.
+///
+///	\returns	true if macroscopic quantities must be written to the grid.
+bool GridObj::_LBM_isMacroStoreStep()
+{
+#if (defined L_IBM_ON || defined L_REGULARISED_BOUNDARIES || defined L_USE_KBC_COLLISION)
+	// Macroscopic quantities are read back from the grid during the step
+	return true;
+#else
+	// Only the last sub-cycle of an L0 step is followed by output
+	int steps_per_L0 = 1 << level;
+	if ((t + 1) % steps_per_L0 != 0)
+		return false;
 
+	// Check the L0 step against the output frequencies
+	int tL0 = (t + 1) / steps_per_L0;
+	if (tL0 % L_GRID_OUT_FREQ == 0 || tL0 % L_RESTART_OUT_FREQ == 0)
+		return true;
+#ifdef L_PROBE_OUTPUT
+	if (tL0 % L_PROBE_OUT_FREQ == 0)
+		return true;
+#endif
+#ifdef L_ADAPTIVE_REFINEMENT
+	if (tL0 % L_AMR_FREQ == 0)
+		return true;
+#endif
+	return false;
+#endif
 }
 
 // *****************************************************************************
@@ -917,7 +1754,8 @@ void GridObj::_LBM_macro_opt(int i, int j, int k, int id, eType type_local) {
 ///			direction. If reset_flag is true, then resets the force vectors to zero.
 ///
 ///	\param	id	flattened ijk index.
-void GridObj::_LBM_forceGrid_opt(int id) {
+///	\param	u_local	velocity of the site.
+void GridObj::_LBM_forceGrid_opt(int id, const double *u_local) {
 
 	/* This routine computes the forces applied along each direction on the lattice
 	from Guo's 2002 scheme. The basic LBM must be modified in two ways: 1) the forces
@@ -948,36 +1786,40 @@ void GridObj::_LBM_forceGrid_opt(int id) {
 
 	*/
 
-	// Declarations
-	double lambda_v, beta_v;
+	// Load Cartesian force once
+	double force_local[L_DIMS];
+	for (int d = 0; d < L_DIMS; d++) {
+		force_local[d] = force_xyz[d + id * L_DIMS];
+	}
 
-	// Reset the lattice forces
-	memset(&force_i[id * L_NUM_VELS], 0, sizeof(double) * L_NUM_VELS);
-	
 	// Now compute force_i components from Cartesian force vector
-	for (size_t v = 0; v < L_NUM_VELS; v++)
+#ifdef L_ENABLE_OPENMP
+#pragma omp simd
+#endif
+	for (int v = 0; v < L_NUM_VELS; v++)
 	{
 
-		// Reset beta_v
-		beta_v = 0.0;
+		// Reset beta_v and the lattice force
+		double beta_v = 0.0;
+		double force_v = 0.0;
 
 		// Compute the lattice forces based on Guo's forcing scheme
-		lambda_v = (1 - 0.5 * omega) * (w[v] / (cs*cs));
+		double lambda_v = (1 - 0.5 * omega) * (Lattice::w[v] / (cs*cs));
 
 		// Dot product (sum over d dimensions)
 		for (int d = 0; d < L_DIMS; d++) {
-			beta_v += (c_opt[v][d] * u[d + id * L_DIMS]);
+			beta_v += (Lattice::c[v][d] * u_local[d]);
 		}
 		beta_v = beta_v * (1 / (cs*cs));
 
 		// Compute force using shorthand sum described above
 		for (int d = 0; d < L_DIMS; d++) {
-			force_i[v + id * L_NUM_VELS] += force_xyz[d + id * L_DIMS] * 
-				(c_opt[v][d] * (1 + beta_v) - u[d + id * L_DIMS]);
+			force_v += force_local[d] * 
+				(Lattice::c[v][d] * (1 + beta_v) - u_local[d]);
 		}
 
 		// Multiply by lambda_v
-		force_i[v + id * L_NUM_VELS] *= lambda_v;
+		force_i[LBM_popIdx(id, v)] = force_v * lambda_v;
 	}
 }
 
@@ -998,8 +1840,9 @@ void GridObj::_LBM_forceGrid_opt(int id) {
 ///	\param	src_x	x-index of site where value is pulled from.
 ///	\param	src_y	y-index of site where value is pulled from.
 ///	\param	src_z	z-index of site where value is pulled from.
+///	\param	f_local	populations of the current site being streamed.
 ///	\return	boolen a indicator as to whether BFL was applied. If not, regular streaming is continued.
-bool GridObj::_LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k, int src_x, int src_y, int src_z)
+bool GridObj::_LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k, int src_x, int src_y, int src_z, double *f_local)
 {
 	/* BFL can be applied easily if only one of the two sites are labelled as BFL.
 	 * If both are labelled BFL, the algorithm here checks to see if there is any 
@@ -1057,9 +1900,9 @@ bool GridObj::_LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k,
 		 * to perform interpolation on pre-stream values pointing towards the
 		 * wall from the BFL site and one site further away from the wall. This
 		 * stencil site can be found from the pull direction unit vector. */
-		int stencil_i = i + c_opt[v][0];
-		int stencil_j = j + c_opt[v][1];
-		int stencil_k = k + c_opt[v][2];
+		int stencil_i = i + Lattice::c[v][0];
+		int stencil_j = j + Lattice::c[v][1];
+		int stencil_k = k + Lattice::c[v][2];
 		int stencil_id = k + j * K_lim + i * K_lim * M_lim;
 
 		/* Only apply if the stencil is valid on this rank. Otherwise, doesn't 
@@ -1069,15 +1912,15 @@ bool GridObj::_LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k,
 			stencil_k >= 0 && stencil_k < K_lim)
 		{
 			// Interpolate pre-stream value then perform bounceback stream
-			fNew[v + id * L_NUM_VELS] =
+			f_local[v] =
 				(1 - 2 * q_link) *
-				(f[GridUtils::getOpposite(v) + stencil_id * L_NUM_VELS] - f[GridUtils::getOpposite(v) + id * L_NUM_VELS])
-				+ f[GridUtils::getOpposite(v) + id * L_NUM_VELS];
+				(f[LBM_popIdx(stencil_id, GridUtils::getOpposite(v))] - f[LBM_popIdx(id, GridUtils::getOpposite(v))])
+				+ f[LBM_popIdx(id, GridUtils::getOpposite(v))];
 
 			// Momentum exchange -- don't include forces computed on halo sites to avoid duplicates
 #ifdef L_LD_OUT
 			if (!GridUtils::isOnRecvLayer(XPos[i], YPos[j], ZPos[k]))
-				ObjectManager::getInstance()->computeLiftDrag(v, id, this, markerID);
+				ObjectManager::getInstance()->computeLiftDrag(v, id, this, markerID, f_local[v]);
 #endif
 		}
 	}
@@ -1088,15 +1931,15 @@ bool GridObj::_LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k,
 		/* Wall must be nearer the source site than the current site. We can 
 		 * compute bounced value at current site from post-stream interpolated
 		 * values pointing away from the wall. */
-		fNew[v + id * L_NUM_VELS] =
+		f_local[v] =
 			(1 - 2 * q_link) *
-			((f[v + id * L_NUM_VELS] - f[GridUtils::getOpposite(v) + id * L_NUM_VELS]) / (2 - 2 * q_link))
-			+ f[GridUtils::getOpposite(v) + id * L_NUM_VELS];
+			((f[LBM_popIdx(id, v)] - f[LBM_popIdx(id, GridUtils::getOpposite(v))]) / (2 - 2 * q_link))
+			+ f[LBM_popIdx(id, GridUtils::getOpposite(v))];
 
 		// Momentum exchange -- don't include forces computed on halo sites to avoid duplicates
 #ifdef L_LD_OUT
 		if (!GridUtils::isOnRecvLayer(XPos[i], YPos[j], ZPos[k]))
-			ObjectManager::getInstance()->computeLiftDrag(v, id, this, markerID);
+			ObjectManager::getInstance()->computeLiftDrag(v, id, this, markerID, f_local[v]);
 #endif
 	}
 
@@ -1111,7 +1954,8 @@ bool GridObj::_LBM_applyBFL_opt(int id, int src_id, int v, int i, int j, int k,
 ///			3D and 2D, respectively.
 ///
 /// \param id		flattened index of the lattice site.
-void GridObj::_LBM_kbcCollide_opt(int id)
+///	\param	f_local	streamed populations of the site which are collided in place.
+void GridObj::_LBM_kbcCollide_opt(int id, double *f_local)
 {
 
 	// Declarations
@@ -1119,24 +1963,22 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 	double dh[L_NUM_VELS];
 	double fneq[L_NUM_VELS];
 	double gamma;
-	std::vector<double> Mneq;
-	std::vector<int> C;
 
 	// Compute required moments and equilibrium moments //
 #if (L_DIMS == 3)
-	int numMoments = 13;
+	const int numMoments = 13;
 #else
-	int numMoments = 3;
+	const int numMoments = 3;
 #endif
-	Mneq.resize(numMoments, 0.0);
-	C.resize(numMoments * L_NUM_VELS, 1);
+	double Mneq[numMoments] = { 0.0 };
+	int C[numMoments * L_NUM_VELS];
 
 	for (int v = 0; v < L_NUM_VELS; v++)
 	{
 
 		// Update feq and store fneq
-		feq[v + id * L_NUM_VELS] = _LBM_equilibrium_opt(id, v);
-		fneq[v] = f[v + id * L_NUM_VELS] - feq[v + id * L_NUM_VELS];
+		feq[LBM_popIdx(id, v)] = _LBM_equilibrium_opt(id, v);
+		fneq[v] = f_local[v] - feq[LBM_popIdx(id, v)];
 
 		// 2-index and 3-index non-equilibrium moments
 		int idx = 0;
@@ -1144,7 +1986,7 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 		{
 			for (int gam = sig; gam < L_DIMS; ++gam)
 			{
-				C[idx + v * numMoments] = c_opt[v][sig] * c_opt[v][gam];
+				C[idx + v * numMoments] = Lattice::c[v][sig] * Lattice::c[v][gam];
 				Mneq[idx] += fneq[v] * C[idx + v * numMoments];
 				idx++;
 
@@ -1155,7 +1997,7 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 					// Don't include if all the same index
 					if (sig != gam || gam != del || sig != del)
 					{
-						C[idx + v * numMoments] = c_opt[v][sig] * c_opt[v][gam] * c_opt[v][del];
+						C[idx + v * numMoments] = Lattice::c[v][sig] * Lattice::c[v][gam] * Lattice::c[v][del];
 						Mneq[idx] += fneq[v] * C[idx + v * numMoments];
 						idx++;
 					}
@@ -1173,11 +2015,11 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 
 #if (L_DIMS == 3)
 
-		if (c_opt[v][0] == 0)
+		if (Lattice::c[v][0] == 0)
 		{
-			if (c_opt[v][1] == 0)
+			if (Lattice::c[v][1] == 0)
 			{
-				if (c_opt[v][2] == 0)
+				if (Lattice::c[v][2] == 0)
 				{
 					// First family
 					ds[v] = (-(Mneq[0] + Mneq[8] + Mneq[12]));
@@ -1185,43 +2027,43 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 				else
 				{
 					// Fourth family
-					ds[v] = ((-(Mneq[0] - Mneq[12]) - (Mneq[8] - Mneq[12])) / 6.0 + (Mneq[0] + Mneq[8] + Mneq[12]) / 6.0 - c_opt[v][2] * 0.5 * (Mneq[2] + Mneq[9]));
+					ds[v] = ((-(Mneq[0] - Mneq[12]) - (Mneq[8] - Mneq[12])) / 6.0 + (Mneq[0] + Mneq[8] + Mneq[12]) / 6.0 - Lattice::c[v][2] * 0.5 * (Mneq[2] + Mneq[9]));
 				}
 			}
 			else
 			{
-				if (c_opt[v][2] == 0)
+				if (Lattice::c[v][2] == 0)
 				{
 					// Third family
-					ds[v] = ((-(Mneq[0] - Mneq[12]) + 2.0 * (Mneq[8] - Mneq[12])) / 6.0 + (Mneq[0] + Mneq[8] + Mneq[12]) / 6.0 - c_opt[v][1] * 0.5 * (Mneq[1] + Mneq[11]));
+					ds[v] = ((-(Mneq[0] - Mneq[12]) + 2.0 * (Mneq[8] - Mneq[12])) / 6.0 + (Mneq[0] + Mneq[8] + Mneq[12]) / 6.0 - Lattice::c[v][1] * 0.5 * (Mneq[1] + Mneq[11]));
 				}
 				else
 				{	// Seventh family
-					ds[v] = (C[10 + v * numMoments] * 0.25 * Mneq[10] + (c_opt[v][2] * 0.25 * Mneq[9] + c_opt[v][1] * 0.25 * Mneq[11]));
+					ds[v] = (C[10 + v * numMoments] * 0.25 * Mneq[10] + (Lattice::c[v][2] * 0.25 * Mneq[9] + Lattice::c[v][1] * 0.25 * Mneq[11]));
 				}
 			}
 		}
 		else
 		{
-			if (c_opt[v][1] == 0)
+			if (Lattice::c[v][1] == 0)
 			{
-				if (c_opt[v][2] == 0)
+				if (Lattice::c[v][2] == 0)
 				{
 					// Second family
-					ds[v] = ((2.0 * (Mneq[0] - Mneq[12]) - (Mneq[8] - Mneq[12])) / 6.0 + (Mneq[0] + Mneq[8] + Mneq[12]) / 6.0 - c_opt[v][0] * 0.5 * (Mneq[4] + Mneq[7]));
+					ds[v] = ((2.0 * (Mneq[0] - Mneq[12]) - (Mneq[8] - Mneq[12])) / 6.0 + (Mneq[0] + Mneq[8] + Mneq[12]) / 6.0 - Lattice::c[v][0] * 0.5 * (Mneq[4] + Mneq[7]));
 				}
 				else
 				{
 					// Sixth family
-					ds[v] = (C[6 + v * numMoments] * 0.25 * Mneq[6] + (c_opt[v][2] * 0.25 * Mneq[2] + c_opt[v][0] * 0.25 * Mneq[7]));
+					ds[v] = (C[6 + v * numMoments] * 0.25 * Mneq[6] + (Lattice::c[v][2] * 0.25 * Mneq[2] + Lattice::c[v][0] * 0.25 * Mneq[7]));
 				}
 			}
 			else
 			{
-				if (c_opt[v][2] == 0)
+				if (Lattice::c[v][2] == 0)
 				{
 					// Fifth family
-					ds[v] = (C[3 + v * numMoments] * 0.25 * Mneq[3] + (c_opt[v][1] * 0.25 * Mneq[1] + c_opt[v][0] * 0.25 * Mneq[4]));
+					ds[v] = (C[3 + v * numMoments] * 0.25 * Mneq[3] + (Lattice::c[v][1] * 0.25 * Mneq[1] + Lattice::c[v][0] * 0.25 * Mneq[4]));
 				}
 				else
 				{
@@ -1232,9 +2074,9 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 		}
 #else
 
-		if (c_opt[v][0] == 0)
+		if (Lattice::c[v][0] == 0)
 		{
-			if (c_opt[v][1] == 0)
+			if (Lattice::c[v][1] == 0)
 			{
 				// First family
 				ds[v] = 0.0;
@@ -1247,7 +2089,7 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 		}
 		else
 		{
-			if (c_opt[v][1] == 0)
+			if (Lattice::c[v][1] == 0)
 			{
 				// Second family
 				ds[v] = 0.25 * (Mneq[0] - Mneq[2]);
@@ -1269,8 +2111,8 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 	for (int v = 0; v < L_NUM_VELS; v++)
 	{
 		// Compute scalar products
-		top_prod += ds[v] * dh[v] / feq[v + id * L_NUM_VELS];
-		bot_prod += dh[v] * dh[v] / feq[v + id * L_NUM_VELS];
+		top_prod += ds[v] * dh[v] / feq[LBM_popIdx(id, v)];
+		bot_prod += dh[v] * dh[v] / feq[LBM_popIdx(id, v)];
 	}
 
 	// Compute 1/beta
@@ -1284,12 +2126,11 @@ void GridObj::_LBM_kbcCollide_opt(int id)
 	for (int v = 0; v < L_NUM_VELS; v++)
 	{
 		// Perform collision
-		fNew[v + id * L_NUM_VELS] =
-			f[v + id * L_NUM_VELS] -
+		f_local[v] -=
 			(1.0 / beta_m1) * (2.0 * ds[v] + gamma * dh[v])
 
 #if (defined L_GRAVITY_ON || defined L_IBM_ON)
-			+ force_i[v + id * L_NUM_VELS]
+			+ force_i[LBM_popIdx(id, v)]
 #endif
 			;
 	}
@@ -1321,6 +2162,9 @@ void GridObj::_LBM_resetForces()
 
 	// Reset Cartesian force vector on every grid site
 #ifdef L_GRAVITY_ON
+#ifdef L_ENABLE_OPENMP
+#pragma omp parallel for
+#endif
 	for (int id = 0; id < N_lim * M_lim * K_lim; ++id)
 		force_xyz[L_GRAVITY_DIRECTION + id * L_DIMS] = rho[id] * gravity * refinement_ratio;
 #else
@@ -1418,11 +2262,155 @@ void GridObj::_LBM_updateInteriorLatticeSite(int i, int j, int k, int subcycle)
 	int id = k + j * K_lim + i * K_lim * M_lim;
 	eType type_local = LatTyp[id];
 
-	// STREAM //
-	_LBM_stream_opt(i, j, k, id, type_local, subcycle);
+	// STREAM (into a scratch buffer as the site is streamed again later) //
+	double f_local[L_NUM_VELS];
+	_LBM_stream_opt(i, j, k, id, type_local, subcycle, f_local);
 
 	// MACROSCOPIC //
-	_LBM_macro_opt(i, j, k, id, type_local);
+	_LBM_macro_opt(i, j, k, id, type_local, f_local);
+}
+
+// *****************************************************************************
+/// \brief	Index in f of a post-collision population.
+///
+///			Code outside the LBM kernel must use this method to read or write
+///			the post-collision populations held in f. With the default two-lattice
+///			scheme this is the same as LBM_popIdx. If L_INPLACE_STREAMING is 
+///			defined, a single population array is streamed in place using the 
+///			AA-pattern and the storage location alternates with the parity of the
+///			number of completed time steps on the grid:
+///
+///				t even : post-collision value is stored in the slot of the
+///						 site it streams to next (pushed);
+///				t odd  : post-collision value is stored at its own site in the
+///						 slot of the opposite direction.
+///
+/// \param	i	x-index of site.
+/// \param	j	y-index of site.
+/// \param	k	z-index of site.
+/// \param	v	lattice direction.
+/// \return		index into f.
+int GridObj::LBM_fIdx(int i, int j, int k, int v) const
+{
+#ifdef L_INPLACE_STREAMING
+	if (t % 2 == 0)
+	{
+		// Downstream site is the upstream site of the opposite direction
+		int v_opp = GridUtils::getOpposite(v);
+		return LBM_popIdx(
+			streamSrcX[i + v_opp * N_lim],
+			streamSrcY[j + v_opp * M_lim],
+			streamSrcZ[k + v_opp * K_lim],
+			v);
+	}
+	return LBM_popIdx(i, j, k, GridUtils::getOpposite(v));
+#else
+	return LBM_popIdx(i, j, k, v);
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Index in f of the population streaming into a site.
+///
+///			Equivalent to LBM_fIdx evaluated at the source site. When streaming in
+///			place the population arriving along v is held in a slot which is only
+///			read and written by the receiving site during the time step, so the 
+///			site stores its collided populations in the slots of the opposite
+///			directions without affecting its neighbours.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	id	flattened ijk index.
+///	\param	v	lattice direction.
+/// \return		index into f.
+int GridObj::_LBM_inIdx_opt(int i, int j, int k, int id, int v)
+{
+#ifdef L_INPLACE_STREAMING
+	// Already pushed to this site by the previous time step
+	if (t % 2 == 0) return LBM_popIdx(id, v);
+#endif
+
+	// Source site (periodic by default)
+	int src_x = streamSrcX[i + v * N_lim];
+	int src_y = streamSrcY[j + v * M_lim];
+	int src_z = streamSrcZ[k + v * K_lim];
+	int src_id = src_z + src_y * K_lim + src_x * K_lim * M_lim;
+
+#ifdef L_INPLACE_STREAMING
+	return LBM_popIdx(src_id, GridUtils::getOpposite(v));
+#else
+	return LBM_popIdx(src_id, v);
+#endif
+}
+
+// *****************************************************************************
+/// \brief	Store the post-stream populations of a site.
+///
+///			Used when the kernel is split by the IBM step. Populations are held in
+///			fNew or, when streaming in place, in the slots they arrived in.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	id	flattened ijk index.
+///	\param	f_local	streamed populations of the site.
+void GridObj::_LBM_storeStreamed_opt(int i, int j, int k, int id, double *f_local)
+{
+	for (int v = 0; v < L_NUM_VELS; ++v)
+	{
+#ifdef L_INPLACE_STREAMING
+		f[_LBM_inIdx_opt(i, j, k, id, v)] = f_local[v];
+#else
+		fNew[LBM_popIdx(id, v)] = f_local[v];
+#endif
+	}
+}
+
+// *****************************************************************************
+/// \brief	Retrieve the post-stream populations of a site.
+///
+///			Counterpart of _LBM_storeStreamed_opt.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	id	flattened ijk index.
+///	\param	f_local	streamed populations of the site.
+void GridObj::_LBM_loadStreamed_opt(int i, int j, int k, int id, double *f_local)
+{
+	for (int v = 0; v < L_NUM_VELS; ++v)
+	{
+#ifdef L_INPLACE_STREAMING
+		f_local[v] = f[_LBM_inIdx_opt(i, j, k, id, v)];
+#else
+		f_local[v] = fNew[LBM_popIdx(id, v)];
+#endif
+	}
+}
+
+// *****************************************************************************
+/// \brief	Store the post-collision populations of a site.
+///
+///			Populations are written to fNew or, when streaming in place, back
+///			into the slot of the opposite direction which is where LBM_fIdx will
+///			find them once the time step is complete.
+///
+/// \param	i	x-index of current site.
+/// \param	j	y-index of current site.
+/// \param	k	z-index of current site.
+///	\param	id	flattened ijk index.
+///	\param	f_local	collided populations of the site.
+void GridObj::_LBM_storeCollided_opt(int i, int j, int k, int id, double *f_local)
+{
+	for (int v = 0; v < L_NUM_VELS; ++v)
+	{
+#ifdef L_INPLACE_STREAMING
+		f[_LBM_inIdx_opt(i, j, k, id, GridUtils::getOpposite(v))] = f_local[v];
+#else
+		fNew[LBM_popIdx(id, v)] = f_local[v];
+#endif
+	}
 }
 
 // *****************************************************************************
@@ -22,6 +22,12 @@
 
 #include "../inc/stdafx.h"
 #include "../inc/GridObj.h"
+#ifdef L_ENABLE_OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <sched.h>
+#endif
 
 /* Mappings of directions for specular reflection:
  * row == reflection plane (eDirection enumeration)
@@ -161,6 +167,29 @@ std::vector<int> GridUtils::onespace(int min, int max)
 	return result;
 }
 
+// *****************************************************************************
+/// \brief	Computes the key of a block along the Z-order (Morton) curve.
+///
+///			The bits of the three indices are interleaved so that sorting by 
+///			the key visits the blocks in a space-filling order in which 
+///			consecutive blocks are spatially close.
+///
+/// \param	i	x-index of block.
+/// \param	j	y-index of block.
+/// \param	k	z-index of block.
+/// \return	Morton key.
+unsigned long long GridUtils::getMortonKey(int i, int j, int k)
+{
+	unsigned long long key = 0;
+	for (int b = 0; b < 21; ++b)
+	{
+		key |= ((static_cast<unsigned long long>(i) >> b) & 1ULL) << (3 * b + 2);
+		key |= ((static_cast<unsigned long long>(j) >> b) & 1ULL) << (3 * b + 1);
+		key |= ((static_cast<unsigned long long>(k) >> b) & 1ULL) << (3 * b);
+	}
+	return key;
+}
+
 // *****************************************************************************
 /// \brief	Computes the L2 norm using the vector components supplied.
 /// \param	val1	first vector component.
@@ -1469,6 +1498,39 @@ void GridUtils::createOutputDirectory(std::string path_str) {
 	return;	// TODO: Handle directory creation errors
 }
 
+// ****************************************************************************
+/// \brief	Write the placement of the OpenMP threads to the log.
+///
+///			Reports the binding policy and the CPU each thread is running on. 
+///			Unbound threads may migrate away from the NUMA node holding the 
+///			pages they first touched so a warning is issued in that case.
+void GridUtils::logThreadAffinity() {
+
+#ifdef L_ENABLE_OPENMP
+	std::vector<int> cpus(omp_get_max_threads(), -1);
+
+#pragma omp parallel
+	{
+#if defined _WIN32
+		cpus[omp_get_thread_num()] = static_cast<int>(GetCurrentProcessorNumber());
+#elif defined __linux__
+		cpus[omp_get_thread_num()] = sched_getcpu();
+#endif
+	}
+
+	const omp_proc_bind_t bind = omp_get_proc_bind();
+	std::string bindNames[] = { "false", "true", "master", "close", "spread" };
+	L_INFO("OpenMP threads: " + std::to_string(cpus.size()) +
+		", binding: " + (bind >= 0 && bind <= 4 ? bindNames[bind] : std::to_string(bind)), GridUtils::logfile);
+
+	for (size_t t = 0; t < cpus.size(); ++t)
+		L_INFO("Thread " + std::to_string(t) + " on CPU " + std::to_string(cpus[t]), GridUtils::logfile);
+
+	if (bind == omp_proc_bind_false)
+		L_WARN("OpenMP threads are not bound -- set OMP_PROC_BIND and OMP_PLACES to keep them near their memory", GridUtils::logfile);
+#endif
+}
+
 // ****************************************************************************
 /// \brief	Reads coordinates and velocity data from a file. 
 ///
@@ -22,6 +22,7 @@
 
 #include "../inc/stdafx.h"
 #include "../inc/GridObj.h"
+#include "../inc/ObjectManager.h"
 
 // Static declarations
 MpiManager* MpiManager::me;
@@ -50,9 +51,29 @@ MpiManager::MpiManager()
 
 #endif
 
-	// Resize buffer arrays based on number of MPI directions
-	f_buffer_send.resize(L_MPI_DIRS, std::vector<double>(0));
-	f_buffer_recv.resize(L_MPI_DIRS, std::vector<double>(0));	
+	// Default halo exchange backend
+	halo_exchange = L_MPI_HALO_EXCHANGE;
+
+	// Populations carried by each message
+	for (int dir = 0; dir < L_MPI_DIRS; dir++)
+	{
+		for (int v = 0; v < L_NUM_VELS; v++)
+		{
+#ifdef L_MPI_CROSSING_POPS
+			/* The neighbour only pulls the populations which stream into it so
+			 * skip any which do not point towards it along every axis on which 
+			 * it is offset. Corners of D3Q19 carry nothing and are not sent. */
+			bool bCrosses = true;
+			for (int d = 0; d < L_DIMS; d++)
+			{
+				if (neighbour_vectors[d][dir] != 0 && Lattice::c[v][d] != neighbour_vectors[d][dir])
+					bCrosses = false;
+			}
+			if (!bCrosses) continue;
+#endif
+			halo_vels[dir].push_back(v);
+		}
+	}
 
 	// Initialise the manager, grid information and topology
 	mpi_init();
@@ -66,10 +87,13 @@ MpiManager::MpiManager()
 
 /// \brief	Default destructor.
 ///
-///			Also closes the MPI logfile.
+///			Also frees the persistent halo requests and closes the MPI logfile.
 ///
 MpiManager::~MpiManager(void)
 {
+	// Release the halo exchange requests
+	mpi_freeHaloRequests();
+
 	// Close the logfile
 	if (logout != nullptr)
 	{
@@ -191,6 +215,16 @@ void MpiManager::mpi_init()
 
 	}
 
+#ifdef L_MPI_SHARED_HALO
+	// Find which neighbours can be reached through shared memory
+	MPI_Comm_split_type(world_comm, MPI_COMM_TYPE_SHARED, my_rank, MPI_INFO_NULL, &node_comm);
+	MPI_Comm_group(node_comm, &node_group);
+	MPI_Group world_group;
+	MPI_Comm_group(world_comm, &world_group);
+	MPI_Group_translate_ranks(world_group, L_MPI_DIRS, neighbour_rank, node_group, neighbour_node_rank);
+	MPI_Group_free(&world_group);
+#endif
+
 	// End Initialisation //
 
 	return;
@@ -217,6 +251,11 @@ void MpiManager::mpi_gridbuild(GridManager* const grid_man)
 	numCells[1] = L_M;
 	numCells[2] = L_K;
 
+#if (defined L_MPI_TOPOLOGY_REPORT || defined L_MPI_SMART_DECOMPOSE)
+	// Calibrated costs from an earlier profiling run
+	if (my_rank == 0) mpi_SDReadCostMap();
+#endif
+
 	// Compute block sizes based on chosen algorithm
 #ifdef L_MPI_TOPOLOGY_REPORT
 	mpi_reportOnDecomposition(dh);
@@ -258,13 +297,13 @@ void MpiManager::mpi_gridbuild(GridManager* const grid_man)
 			switch (d)
 			{
 			case 0:
-				local_size.push_back(cRankSizeX[my_rank] + 2);
+				local_size.push_back(cRankSizeX[my_rank] + 2 * L_HALO_WIDTH);
 				break;
 			case 1:
-				local_size.push_back(cRankSizeY[my_rank] + 2);
+				local_size.push_back(cRankSizeY[my_rank] + 2 * L_HALO_WIDTH);
 				break;
 			case 2:
-				local_size.push_back(cRankSizeZ[my_rank] + 2);
+				local_size.push_back(cRankSizeZ[my_rank] + 2 * L_HALO_WIDTH);
 				break;
 
 			default:
@@ -370,7 +409,10 @@ void MpiManager::mpi_gridbuild(GridManager* const grid_man)
 	 * Note that if we don't want to have a halo in a given direction due to there
 	 * only being one core in that direction and need to avoid Issue #157 then we
 	 * need to set the sender and receiver layers to be outside the world space
-	 * used by LUMA, i.e. < 0.0. */
+	 * used by LUMA, i.e. < 0.0.
+	 *
+	 * Each layer is L_HALO_WIDTH sites thick. */
+	double halo = L_HALO_WIDTH * dh;
 
 	// X
 	if (dimensions[eXDirection] == 1)
@@ -387,30 +429,30 @@ void MpiManager::mpi_gridbuild(GridManager* const grid_man)
 	else
 	{
 		sender_layer_pos.X[eLeftMin] = rank_core_edge[eXMin][my_rank];
-		sender_layer_pos.X[eLeftMax] = rank_core_edge[eXMin][my_rank] + dh;
-		sender_layer_pos.X[eRightMin] = rank_core_edge[eXMax][my_rank] - dh;
+		sender_layer_pos.X[eLeftMax] = rank_core_edge[eXMin][my_rank] + halo;
+		sender_layer_pos.X[eRightMin] = rank_core_edge[eXMax][my_rank] - halo;
 		sender_layer_pos.X[eRightMax] = rank_core_edge[eXMax][my_rank];
 
 		// Check if need to wrap or not
-		if (sender_layer_pos.X[eLeftMin] - dh < 0.0)
+		if (sender_layer_pos.X[eLeftMin] - halo < 0.0)
 		{
-			recv_layer_pos.X[eLeftMin] = grid_man->global_edges[eXMax][0] - dh;
+			recv_layer_pos.X[eLeftMin] = grid_man->global_edges[eXMax][0] - halo;
 			recv_layer_pos.X[eLeftMax] = grid_man->global_edges[eXMax][0];
 		}
 		else
 		{
-			recv_layer_pos.X[eLeftMin] = sender_layer_pos.X[eLeftMin] - dh;
+			recv_layer_pos.X[eLeftMin] = sender_layer_pos.X[eLeftMin] - halo;
 			recv_layer_pos.X[eLeftMax] = sender_layer_pos.X[eLeftMin];
 		}
-		if (sender_layer_pos.X[eRightMax] + dh > grid_man->global_edges[eXMax][0])
+		if (sender_layer_pos.X[eRightMax] + halo > grid_man->global_edges[eXMax][0])
 		{
 			recv_layer_pos.X[eRightMin] = 0.0;
-			recv_layer_pos.X[eRightMax] = dh;
+			recv_layer_pos.X[eRightMax] = halo;
 		}
 		else
 		{
 			recv_layer_pos.X[eRightMin] = sender_layer_pos.X[eRightMax];
-			recv_layer_pos.X[eRightMax] = sender_layer_pos.X[eRightMax] + dh;
+			recv_layer_pos.X[eRightMax] = sender_layer_pos.X[eRightMax] + halo;
 		}
 	}
 
@@ -429,28 +471,28 @@ void MpiManager::mpi_gridbuild(GridManager* const grid_man)
 	else
 	{
 		sender_layer_pos.Y[eLeftMin] = rank_core_edge[eYMin][my_rank];
-		sender_layer_pos.Y[eLeftMax] = rank_core_edge[eYMin][my_rank] + dh;
-		sender_layer_pos.Y[eRightMin] = rank_core_edge[eYMax][my_rank] - dh;
+		sender_layer_pos.Y[eLeftMax] = rank_core_edge[eYMin][my_rank] + halo;
+		sender_layer_pos.Y[eRightMin] = rank_core_edge[eYMax][my_rank] - halo;
 		sender_layer_pos.Y[eRightMax] = rank_core_edge[eYMax][my_rank];
-		if (sender_layer_pos.Y[eLeftMin] - dh < 0.0)
+		if (sender_layer_pos.Y[eLeftMin] - halo < 0.0)
 		{
-			recv_layer_pos.Y[eLeftMin] = grid_man->global_edges[eYMax][0] - dh;
+			recv_layer_pos.Y[eLeftMin] = grid_man->global_edges[eYMax][0] - halo;
 			recv_layer_pos.Y[eLeftMax] = grid_man->global_edges[eYMax][0];
 		}
 		else
 		{
-			recv_layer_pos.Y[eLeftMin] = sender_layer_pos.Y[eLeftMin] - dh;
+			recv_layer_pos.Y[eLeftMin] = sender_layer_pos.Y[eLeftMin] - halo;
 			recv_layer_pos.Y[eLeftMax] = sender_layer_pos.Y[eLeftMin];
 		}
-		if (sender_layer_pos.Y[eRightMax] + dh > grid_man->global_edges[eYMax][0])
+		if (sender_layer_pos.Y[eRightMax] + halo > grid_man->global_edges[eYMax][0])
 		{
 			recv_layer_pos.Y[eRightMin] = 0.0;
-			recv_layer_pos.Y[eRightMax] = dh;
+			recv_layer_pos.Y[eRightMax] = halo;
 		}
 		else
 		{
 			recv_layer_pos.Y[eRightMin] = sender_layer_pos.Y[eRightMax];
-			recv_layer_pos.Y[eRightMax] = sender_layer_pos.Y[eRightMax] + dh;
+			recv_layer_pos.Y[eRightMax] = sender_layer_pos.Y[eRightMax] + halo;
 		}
 	}
 
@@ -470,28 +512,28 @@ void MpiManager::mpi_gridbuild(GridManager* const grid_man)
 	else
 	{
 		sender_layer_pos.Z[eLeftMin] = rank_core_edge[eZMin][my_rank];
-		sender_layer_pos.Z[eLeftMax] = rank_core_edge[eZMin][my_rank] + dh;
-		sender_layer_pos.Z[eRightMin] = rank_core_edge[eZMax][my_rank] - dh;
+		sender_layer_pos.Z[eLeftMax] = rank_core_edge[eZMin][my_rank] + halo;
+		sender_layer_pos.Z[eRightMin] = rank_core_edge[eZMax][my_rank] - halo;
 		sender_layer_pos.Z[eRightMax] = rank_core_edge[eZMax][my_rank];
-		if (sender_layer_pos.Z[eLeftMin] - dh < 0.0)
+		if (sender_layer_pos.Z[eLeftMin] - halo < 0.0)
 		{
-			recv_layer_pos.Z[eLeftMin] = grid_man->global_edges[eZMax][0] - dh;
+			recv_layer_pos.Z[eLeftMin] = grid_man->global_edges[eZMax][0] - halo;
 			recv_layer_pos.Z[eLeftMax] = grid_man->global_edges[eZMax][0];
 		}
 		else
 		{
-			recv_layer_pos.Z[eLeftMin] = sender_layer_pos.Z[eLeftMin] - dh;
+			recv_layer_pos.Z[eLeftMin] = sender_layer_pos.Z[eLeftMin] - halo;
 			recv_layer_pos.Z[eLeftMax] = sender_layer_pos.Z[eLeftMin];
 		}
-		if (sender_layer_pos.Z[eRightMax] + dh > grid_man->global_edges[eZMax][0])
+		if (sender_layer_pos.Z[eRightMax] + halo > grid_man->global_edges[eZMax][0])
 		{
 			recv_layer_pos.Z[eRightMin] = 0.0;
-			recv_layer_pos.Z[eRightMax] = dh;
+			recv_layer_pos.Z[eRightMax] = halo;
 		}
 		else
 		{
 			recv_layer_pos.Z[eRightMin] = sender_layer_pos.Z[eRightMax];
-			recv_layer_pos.Z[eRightMax] = sender_layer_pos.Z[eRightMax] + dh;
+			recv_layer_pos.Z[eRightMax] = sender_layer_pos.Z[eRightMax] + halo;
 		}
 }
 #endif
@@ -578,19 +620,26 @@ void MpiManager::mpi_communicateBlockEdges()
 ///
 ///			When verbose MPI logging is turned on this method will write out 
 ///			the communication buffer to an ASCII file.
-void MpiManager::mpi_writeout_buf( std::string filename, int dir ) {
+///
+/// \param	filename	name of file to write.
+/// \param	dir			communication direction.
+/// \param	bufs		sender buffer info of the grid.
+/// \param	bufr		receiver buffer info of the grid.
+void MpiManager::mpi_writeout_buf( std::string filename, int dir, BufferSizeStruct* const bufs, BufferSizeStruct* const bufr ) {
 
 	std::ofstream rankout;
 	rankout.open(filename.c_str(), std::ios::out);
 
-	rankout << "f_buffer_send is of size " << f_buffer_send[dir].size() << " with values: " << std::endl;
-	for (size_t v = 0; v < f_buffer_send[dir].size(); v++) {
-		rankout << f_buffer_send[dir][v] << std::endl;
+	size_t send_size = bufs->size[dir] * halo_vels[dir].size();
+	rankout << "Send buffer is of size " << send_size << " with values: " << std::endl;
+	for (size_t v = 0; v < send_size; v++) {
+		rankout << bufs->data[dir][v] << std::endl;
 	}
 
-	rankout << "f_buffer_recv is of size " << f_buffer_recv[dir].size() << " with values: " << std::endl;
-	for (size_t v = 0; v < f_buffer_recv[dir].size(); v++) {
-		rankout << f_buffer_recv[dir][v] << std::endl;
+	size_t recv_size = bufr->size[dir] * halo_vels[dir].size();
+	rankout << "Receive buffer is of size " << recv_size << " with values: " << std::endl;
+	for (size_t v = 0; v < recv_size; v++) {
+		rankout << bufr->data[dir][v] << std::endl;
 	}
 
 	rankout.close();
@@ -610,17 +659,39 @@ void MpiManager::mpi_writeout_buf( std::string filename, int dir ) {
 /// \param	reg	region number of grid to communicate.
 void MpiManager::mpi_communicate(int lev, int reg) {
 
-	// Wall clock variables
-	clock_t t_start, t_end, secs;
+	// Get grid object
+	GridObj* Grid = NULL;
+	GridUtils::getGrid(GridManager::getInstance()->Grids, lev, reg,  Grid);
 
-	// Tag
-	int TAG;
-	int send_count = 0;
+	mpi_communicateStart(lev, reg, Grid->f.data());
+	mpi_communicateFinish(lev, reg);
+
+}
+
+// ************************************************************************* //
+/// \brief	Start of the communication routine.
+///
+///			Packs the sender layers of the grid of the supplied level and 
+///			region and posts the sends and receives in all valid directions.
+///			Work which does not touch the sender or receiver layers may be done
+///			before the matching call to mpi_communicateFinish().
+///
+/// \param	lev	level of grid to communicate.
+/// \param	reg	region number of grid to communicate.
+/// \param	pop	populations of the grid to send.
+void MpiManager::mpi_communicateStart(int lev, int reg, const popType* const pop) {
+
+	// Wall clock variables
+	clock_t t_start = clock();
 
 	// Get grid object
 	GridObj* Grid = NULL;
 	GridUtils::getGrid(GridManager::getInstance()->Grids, lev, reg,  Grid);
 
+	// Get the buffers and requests of the grid
+	BufferSizeStruct *bufs = mpi_getBufferInfo(buffer_send_info, lev, reg);
+	BufferSizeStruct *bufr = mpi_getBufferInfo(buffer_recv_info, lev, reg);
+
 
 	///////////////////////
 	// MPI Communication //
@@ -637,99 +708,184 @@ void MpiManager::mpi_communicate(int lev, int reg) {
 	* will be out of sync. Need to allow the blocking nature of the send and receive calls to force correct 
 	* synchronisation between processes and only call barriers outside the grid scope.
 	*
-	* For each sending direction, pack and load a message into the message queue 
-	* for the destination rank with tag associated with direction.
-	* Then for each receive direction, pull message with correct tag from the queue 
-	* and unpack.
+	* The messages of each grid never change between exchanges so each direction
+	* has its own buffer and a persistent request bound to it, both set up once 
+	* by mpi_buildHaloRequests(). Here the receives are restarted, each send 
+	* buffer is packed and the sends are restarted. The messages are unpacked 
+	* as they arrive in mpi_communicateFinish(). The same messages may instead
+	* be exchanged by a single neighbourhood collective over the ranks holding 
+	* the grid which is unpacked once it completes.
 	*
-	* In order to do this, need non-blocking send and receive calls and each needs
-	* their own buffer to store the information which cannot be touched until the 
-	* send is completed, hence this implementation carries a bigger memeory requirement
-	* as buffer reuse through the direction loop is not possible.
-	* Although MPI_Bsend() will do something similar it relies on creating and filling 
-	* MPI background buffers which might have limited resources and which is slower so 
-	* we use the MPI Manager class to hold the buffer in house. */
+	* Messages to neighbours on the same node may instead be packed into a 
+	* shared memory window which the neighbour unpacks from directly. An 
+	* exposure epoch opened here tells the neighbours the messages are ready 
+	* and is closed once they have all been read. */
+
+	mpi_haloPost(Grid, pop, bufs, bufr);
+
+	// Time spent so far
+	comm_secs = clock() - t_start;
+
+}
+
+// ************************************************************************* //
+/// \brief	End of the communication routine.
+///
+///			Unpacks the messages posted by mpi_communicateStart() into the 
+///			receiver layers of the grid of the supplied level and region as 
+///			they arrive and waits for the sends to complete.
+///
+/// \param	lev	level of grid to communicate.
+/// \param	reg	region number of grid to communicate.
+void MpiManager::mpi_communicateFinish(int lev, int reg) {
+
+	// Wall clock variables
+	clock_t t_start, t_end, secs;
+
+	// Get grid object
+	GridObj* Grid = NULL;
+	GridUtils::getGrid(GridManager::getInstance()->Grids, lev, reg,  Grid);
 
 	// Start the clock
 	t_start = clock();
 
-	// Loop over directions in Cartesian topology
-	for (int dir = 0; dir < L_MPI_DIRS; dir++)
-	{
+	// Get the buffers and requests of the grid
+	BufferSizeStruct *bufs = mpi_getBufferInfo(buffer_send_info, lev, reg);
+	BufferSizeStruct *bufr = mpi_getBufferInfo(buffer_recv_info, lev, reg);
 
-		/* Create a unique tag based on level (< 32), region (< 10) and direction (< 100).
-		 * MPICH limits state that tag value cannot be greater than 32767 */
-		TAG = ((Grid->level + 1) * 1000) + ((Grid->region_number + 1) * 100) + dir;
+	mpi_haloComplete(Grid, bufs, bufr);
 
 #ifdef L_MPI_VERBOSE
-		*logout << "Processing Message with Tag --> " << TAG << std::endl;
+	for (int dir = 0; dir < L_MPI_DIRS; dir++)
+	{
+		*logout << "SUMMARY for L" << Grid->level << "R" << Grid->region_number << " -- Direction " << dir
+			<< " -- Sent " << bufs->size[dir] << " to " << neighbour_rank[dir]
+			<< ": Received " << bufr->size[dir] << " from " << neighbour_rank[mpi_getOpposite(dir)] << std::endl;
+
+		// Write out buffers
+		std::string filename = GridUtils::path_str + "/mpiBuffer_Rank" + std::to_string(my_rank) + "_Dir" + std::to_string(dir) + ".out";
+		mpi_writeout_buf(filename, dir, bufs, bufr);
+	}
 #endif
 
-		////////////////////////////
-		// Resize and Pack Buffer //
-		////////////////////////////
 
-		// Adjust buffer size
-		for (MpiManager::BufferSizeStruct bufs : buffer_send_info) {
-			if (bufs.level == Grid->level && bufs.region == Grid->region_number) {
-				f_buffer_send[dir].resize(bufs.size[dir] * L_NUM_VELS);
-			}
-		}
+	// Print Time of MPI comms
+	t_end = clock();
+	secs = t_end - t_start + comm_secs;
 
-		// Only pack and send if required
-		if (f_buffer_send[dir].size()) {
+	// Update average MPI overhead time for this particular grid
+	Grid->timeav_mpi_overhead *= (Grid->t-1);
+	Grid->timeav_mpi_overhead += ((double)secs)/CLOCKS_PER_SEC;
+	Grid->timeav_mpi_overhead /= Grid->t;
 
-			// Pass direction and Grid by reference and pack if required
-			mpi_buffer_pack( dir, Grid );
-		
+#ifdef L_TEXTOUT
+	if (Grid->t % L_GRID_OUT_FREQ == 0) {
+		*GridUtils::logfile << "Writing out to <Grids.out>" << std::endl;
+		Grid->io_textout("POST MPI COMMS");
+	}
+#endif
 
-			///////////////
-			// Post Send //
-			///////////////
+	if (Grid->t % L_GRID_OUT_FREQ == 0) {
+		// Performance Data
+		L_INFO("MPI overhead taking an average of " + 
+			std::to_string(Grid->timeav_mpi_overhead * 1000) + "ms", GridUtils::logfile);
+	}
 
-			send_count++;
 
-#ifdef L_MPI_VERBOSE
-			*logout << "L" << Grid->level << "R" << Grid->region_number << " -- Direction " << dir 
-								<< " -->  Posting Send for " << f_buffer_send[dir].size() / L_NUM_VELS
-								<< " sites to Rank " << neighbour_rank[dir] << " with tag " << TAG << "." << std::endl;
-#endif
-			// Post send message to message queue and log request handle in array
-			MPI_Isend( &f_buffer_send[dir].front(), static_cast<int>(f_buffer_send[dir].size()), MPI_DOUBLE, neighbour_rank[dir], 
-				TAG, world_comm, &send_requests[send_count-1] );
+}
+
+// ************************************************************************* //
+/// \brief	Pack and post the halo messages of a grid.
+///
+///			Uses the backend chosen by mpi_setHaloExchange() for the messages
+///			which are not exchanged through shared memory.
+///
+/// \param	g		grid to communicate.
+/// \param	pop		populations of the grid to send.
+/// \param	bufs	sender buffer info of the grid.
+/// \param	bufr	receiver buffer info of the grid.
+void MpiManager::mpi_haloPost(GridObj* const g, const popType* const pop, BufferSizeStruct* const bufs, BufferSizeStruct* const bufr) {
 
 #ifdef L_MPI_VERBOSE
-			*logout << "Direction " << dir << " --> Send Posted." << std::endl;
+	*logout << "Starting " << bufr->count << " receives and " << bufs->count 
+		<< " sends on L" << g->level << "R" << g->region_number << "." << std::endl;
 #endif
 
-		}
+	// Post the receives first so messages can land directly in the buffers
+	if (halo_exchange != eNeighbourCollective) MPI_Startall(bufr->count, bufr->requests);
 
-		// Find opposite direction (neighbour it receives from)
-		int opp_dir = mpi_getOpposite(dir);
-		
-		// Resize the receive buffer
-		for (MpiManager::BufferSizeStruct bufr : buffer_recv_info) {
-			if (bufr.level == Grid->level && bufr.region == Grid->region_number) {
-				f_buffer_recv[dir].resize(bufr.size[dir] * L_NUM_VELS);
-			}
-		}
+	// Pack the send buffers
+	for (int n = 0; n < bufs->count; n++)
+	{
+		mpi_buffer_pack(bufs->dirs[n], g, pop, bufs);
+	}
 
+#ifdef L_MPI_SHARED_HALO
+	// Pack the on-node messages into shared memory and expose them to the neighbours
+	for (int n = 0; n < bufs->shared_count; n++)
+	{
+		mpi_buffer_pack(bufs->shared_dirs[n], g, pop, bufs);
+	}
+	if (bufs->shared_group != MPI_GROUP_EMPTY) MPI_Win_post(bufs->shared_group, MPI_MODE_NOPUT, bufs->win);
+#endif
 
-		///////////////////
-		// Fetch Message //
-		///////////////////
+	// Post the sends
+	if (halo_exchange != eNeighbourCollective)
+	{
+		MPI_Startall(bufs->count, bufs->requests);
+	}
+	else
+	{
+		// Non-blocking so the interior can still be updated while it progresses
+		MPI_Ineighbor_alltoallv(bufs->buffer.data(), bufs->counts.data(), bufs->displs.data(), L_MPI_POP_TYPE, 
+			bufr->buffer.data(), bufr->counts.data(), bufr->displs.data(), L_MPI_POP_TYPE, 
+			bufs->graph_comm, &bufs->coll_request);
+	}
 
-		if (f_buffer_recv[dir].size()) {
+}
 
-#ifdef L_MPI_VERBOSE
-			*logout << "L" << Grid->level << "R" << Grid->region_number << " -- Direction " << dir 
-								<< " -->  Fetching message for " << f_buffer_recv[dir].size() / L_NUM_VELS	
-								<< " sites from Rank " << neighbour_rank[opp_dir] << " with tag " << TAG << "." << std::endl;
+// ************************************************************************* //
+/// \brief	Wait for and unpack the halo messages of a grid.
+///
+///			Completes the exchange started by mpi_haloPost().
+///
+/// \param	g		grid to communicate.
+/// \param	bufs	sender buffer info of the grid.
+/// \param	bufr	receiver buffer info of the grid.
+void MpiManager::mpi_haloComplete(GridObj* const g, BufferSizeStruct* const bufs, BufferSizeStruct* const bufr) {
+
+#ifdef L_MPI_SHARED_HALO
+	// Unpack the on-node messages straight from the memory of the neighbours
+	if (bufr->shared_group != MPI_GROUP_EMPTY) MPI_Win_start(bufr->shared_group, 0, bufr->win);
+	for (int n = 0; n < bufr->shared_count; n++)
+	{
+		mpi_buffer_unpack(bufr->shared_dirs[n], g, bufr);
+	}
+	if (bufr->shared_group != MPI_GROUP_EMPTY) MPI_Win_complete(bufr->win);
 #endif
 
-			// Use a blocking receive call if required
-			MPI_Recv( &f_buffer_recv[dir].front(), static_cast<int>(f_buffer_recv[dir].size()), MPI_DOUBLE, neighbour_rank[opp_dir], 
-				TAG, world_comm, &recv_stat );
+	if (halo_exchange == eNeighbourCollective)
+	{
+		// Every message has arrived once the collective completes
+		MPI_Wait(&bufs->coll_request, MPI_STATUS_IGNORE);
+		for (int n = 0; n < bufr->count; n++)
+		{
+			mpi_buffer_unpack(bufr->dirs[n], g, bufr);
+		}
+	}
+	else
+	{
+		for (int n = 0; n < bufr->count; n++)
+		{
+
+			///////////////////
+			// Fetch Message //
+			///////////////////
+
+			// Wait for any outstanding message (completed persistent requests become inactive)
+			int idx;
+			MPI_Waitany(bufr->count, bufr->requests, &idx, &recv_stat);
+			int dir = bufr->dirs[idx];
 
 #ifdef L_MPI_VERBOSE
 			*logout << "Direction " << dir << " --> Received." << std::endl;
@@ -740,57 +896,107 @@ void MpiManager::mpi_communicate(int lev, int reg) {
 			///////////////////////////
 
 			// Pass direction and Grid by reference
-			mpi_buffer_unpack( dir, Grid );
+			mpi_buffer_unpack( dir, g, bufr );
 
 		}
 
 #ifdef L_MPI_VERBOSE
-
-		*logout << "SUMMARY for L" << Grid->level << "R" << Grid->region_number << " -- Direction " << dir
-			<< " -- Sent " << f_buffer_send[dir].size() / L_NUM_VELS << " to " << neighbour_rank[dir]
-			<< ": Received " << f_buffer_recv[dir].size() / L_NUM_VELS << " from " << neighbour_rank[opp_dir] << std::endl;
-
-		// Write out buffers
-		std::string filename = GridUtils::path_str + "/mpiBuffer_Rank" + std::to_string(my_rank) + "_Dir" + std::to_string(dir) + ".out";
-		mpi_writeout_buf(filename, dir);
+		*logout << " *********************** Waiting for Sends to be Received on L" + 
+			std::to_string(g->level) + "R" + std::to_string(g->region_number) + 
+			" *********************** " << std::endl;
 #endif
 
+		/* Wait until other processes have handled all the sends from this rank.
+		 * The persistent requests are left inactive rather than destroyed so they
+		 * can be restarted by the next exchange. */
+		MPI_Waitall(bufs->count, bufs->requests, send_stat);
 	}
 
-#ifdef L_MPI_VERBOSE
-	*logout << " *********************** Waiting for Sends to be Received on L" + 
-		std::to_string(lev) + "R" + std::to_string(reg) + 
-		" *********************** " << std::endl;
+#ifdef L_MPI_SHARED_HALO
+	// Wait for the neighbours to finish reading before the messages are repacked
+	if (bufs->shared_group != MPI_GROUP_EMPTY) MPI_Win_wait(bufs->win);
 #endif
 
-	/* Wait until other processes have handled all the sends from this rank
-	 * Note that calls to this command destroy the handles once complete so
-	 * do not need to clear the array afterward. */
-	MPI_Waitall(send_count,send_requests,send_stat);
+}
 
+// ************************************************************************* //
+/// \brief	Choose the backend of the halo exchange.
+///
+///			The backend set by L_MPI_HALO_EXCHANGE may be overridden at run 
+///			time by passing -halo followed by p2p, neighbour or fastest. The 
+///			fastest backend is found by timing L_MPI_HALO_TRIALS exchanges of 
+///			every grid with each, taking the time of the slowest rank. Must be
+///			called by all processes after mpi_buffer_size() and before time 
+///			stepping as the trial exchanges rewrite the halos.
+///
+/// \param	argc	number of command line arguments.
+/// \param	argv	command line arguments.
+void MpiManager::mpi_setHaloExchange(int argc, char* argv[]) {
 
-	// Print Time of MPI comms
-	t_end = clock();
-	secs = t_end - t_start;
+	// Run-time override
+	for (int a = 1; a < argc - 1; a++)
+	{
+		if (std::string(argv[a]) != "-halo") continue;
 
-	// Update average MPI overhead time for this particular grid
-	Grid->timeav_mpi_overhead *= (Grid->t-1);
-	Grid->timeav_mpi_overhead += ((double)secs)/CLOCKS_PER_SEC;
-	Grid->timeav_mpi_overhead /= Grid->t;
+		std::string choice(argv[a + 1]);
+		if (choice == "p2p") halo_exchange = ePointToPoint;
+		else if (choice == "neighbour") halo_exchange = eNeighbourCollective;
+		else if (choice == "fastest") halo_exchange = eFastestExchange;
+		else L_ERROR("Unknown halo exchange \"" + choice + "\". Use p2p, neighbour or fastest. Exiting.", GridUtils::logfile);
+	}
 
-#ifdef L_TEXTOUT
-	if (Grid->t % L_GRID_OUT_FREQ == 0) {
-		*GridUtils::logfile << "Writing out to <Grids.out>" << std::endl;
-		Grid->io_textout("POST MPI COMMS");
+	// Time both backends and keep the faster
+	if (halo_exchange == eFastestExchange)
+	{
+		const eHaloExchange backends[2] = { ePointToPoint, eNeighbourCollective };
+		double trialTime[2];
+		for (int b = 0; b < 2; b++)
+		{
+			halo_exchange = backends[b];
+			MPI_Barrier(world_comm);
+			double t_start = MPI_Wtime();
+
+			for (int n = 0; n < L_MPI_HALO_TRIALS; n++)
+			{
+				for (size_t i = 0; i < buffer_send_info.size(); i++)
+				{
+					GridObj *g = NULL;
+					GridUtils::getGrid(GridManager::getInstance()->Grids, buffer_send_info[i].level, buffer_send_info[i].region, g);
+					mpi_haloPost(g, g->f.data(), &buffer_send_info[i], &buffer_recv_info[i]);
+					mpi_haloComplete(g, &buffer_send_info[i], &buffer_recv_info[i]);
+				}
+			}
+
+			double secs = (MPI_Wtime() - t_start) / L_MPI_HALO_TRIALS;
+			MPI_Allreduce(&secs, &trialTime[b], 1, MPI_DOUBLE, MPI_MAX, world_comm);
+		}
+
+		L_INFO("Halo exchange of all grids takes " + std::to_string(trialTime[0] * 1000) + 
+			"ms point-to-point and " + std::to_string(trialTime[1] * 1000) + 
+			"ms by neighbourhood collective.", GridUtils::logfile);
+		halo_exchange = (trialTime[1] < trialTime[0] ? eNeighbourCollective : ePointToPoint);
 	}
-#endif
 
-	if (Grid->t % L_GRID_OUT_FREQ == 0) {
-		// Performance Data
-		L_INFO("MPI overhead taking an average of " + 
-			std::to_string(Grid->timeav_mpi_overhead * 1000) + "ms", GridUtils::logfile);
+	L_INFO(std::string("Halo exchange using ") + 
+		(halo_exchange == eNeighbourCollective ? "neighbourhood collectives." : "point-to-point messages."), GridUtils::logfile);
+
+}
+
+// ************************************************************************* //
+/// \brief	Helper method to find the buffer info of a grid.
+///
+/// \param	info	buffer info of the sender or receiver layers.
+/// \param	lev		level of grid.
+/// \param	reg		region number of grid.
+/// \returns		pointer to the buffer info of the grid.
+MpiManager::BufferSizeStruct* MpiManager::mpi_getBufferInfo(std::vector<BufferSizeStruct>& info, int lev, int reg) {
+
+	for (BufferSizeStruct& buf : info) {
+		if (buf.level == lev && buf.region == reg) return &buf;
 	}
 
+	L_ERROR("No buffer information for L" + std::to_string(lev) + "R" + std::to_string(reg) + ". Exiting.", GridUtils::logfile);
+	return nullptr;
 
 }
 
@@ -861,6 +1067,9 @@ void MpiManager::mpi_buffer_size() {
 		}
 	}
 
+	// Set up the buffers and persistent requests now the sizes are known
+	mpi_buildHaloRequests();
+
 	*GridUtils::logfile << "Complete." << std::endl;
 
 #ifdef L_MPI_VERBOSE
@@ -888,7 +1097,7 @@ void MpiManager::mpi_buffer_size() {
 				if (l == 0 && r != 0) continue;		// L0 can only be R0
 
 				// Try retireve the buffer size info
-				for (MpiManager::BufferSizeStruct bufs : buffer_send_info)
+				for (const MpiManager::BufferSizeStruct& bufs : buffer_send_info)
 				{
 					if (bufs.level == l && bufs.region == r)
 					{
@@ -934,7 +1143,7 @@ void MpiManager::mpi_buffer_size() {
 				if (l == 0 && r != 0) continue;		// L0 can only be R0
 
 				// Try retireve the buffer size info
-				for (MpiManager::BufferSizeStruct bufr : buffer_recv_info)
+				for (const MpiManager::BufferSizeStruct& bufr : buffer_recv_info)
 				{
 					if (bufr.level == l && bufr.region == r)
 					{
@@ -973,6 +1182,316 @@ void MpiManager::mpi_buffer_size() {
 
 }
 
+// ************************************************************************* //
+/// \brief	Set up the persistent halo exchange of every grid.
+///
+///			Allocates the message buffer of each grid once, holding the 
+///			non-empty messages one after another, and binds a persistent send
+///			or receive request to each message so that an exchange only has 
+///			to pack, restart, wait and unpack. Must be called by all 
+///			processes once the buffer sizes are known.
+void MpiManager::mpi_buildHaloRequests() {
+
+	// Sends
+	for (BufferSizeStruct& bufs : buffer_send_info)
+	{
+		bufs.count = 0;
+		bufs.shared_count = 0;
+		bufs.counts.clear();
+		bufs.displs.clear();
+		int total = 0;
+		for (int dir = 0; dir < L_MPI_DIRS; dir++)
+		{
+			if (bufs.size[dir] == 0 || halo_vels[dir].empty()) continue;
+
+#ifdef L_MPI_SHARED_HALO
+			// Packed straight into shared memory for an on-node neighbour
+			if (neighbour_node_rank[dir] != MPI_UNDEFINED)
+			{
+				bufs.shared_dirs[bufs.shared_count++] = dir;
+				continue;
+			}
+#endif
+
+			bufs.dirs[bufs.count++] = dir;
+			bufs.counts.push_back(bufs.size[dir] * static_cast<int>(halo_vels[dir].size()));
+			bufs.displs.push_back(total);
+			total += bufs.counts.back();
+		}
+
+		bufs.buffer.resize(total);
+		for (int n = 0; n < bufs.count; n++)
+		{
+			int dir = bufs.dirs[n];
+			bufs.data[dir] = bufs.buffer.data() + bufs.displs[n];
+
+			/* Create a unique tag based on level (< 32), region (< 10) and direction (< 100).
+			 * MPICH limits state that tag value cannot be greater than 32767 */
+			int TAG = ((bufs.level + 1) * 1000) + ((bufs.region + 1) * 100) + dir;
+
+			MPI_Send_init(bufs.data[dir], bufs.counts[n], L_MPI_POP_TYPE, 
+				neighbour_rank[dir], TAG, world_comm, &bufs.requests[n]);
+		}
+	}
+
+	// Receives (from the neighbour in the opposite direction)
+	for (BufferSizeStruct& bufr : buffer_recv_info)
+	{
+		bufr.count = 0;
+		bufr.shared_count = 0;
+		bufr.counts.clear();
+		bufr.displs.clear();
+		int total = 0;
+		for (int dir = 0; dir < L_MPI_DIRS; dir++)
+		{
+			if (bufr.size[dir] == 0 || halo_vels[dir].empty()) continue;
+
+#ifdef L_MPI_SHARED_HALO
+			// Unpacked straight from the shared memory of an on-node neighbour
+			if (neighbour_node_rank[mpi_getOpposite(dir)] != MPI_UNDEFINED)
+			{
+				bufr.shared_dirs[bufr.shared_count++] = dir;
+				continue;
+			}
+#endif
+
+			bufr.dirs[bufr.count++] = dir;
+			bufr.counts.push_back(bufr.size[dir] * static_cast<int>(halo_vels[dir].size()));
+			bufr.displs.push_back(total);
+			total += bufr.counts.back();
+		}
+
+		bufr.buffer.resize(total);
+		for (int n = 0; n < bufr.count; n++)
+		{
+			int dir = bufr.dirs[n];
+			bufr.data[dir] = bufr.buffer.data() + bufr.displs[n];
+
+			int TAG = ((bufr.level + 1) * 1000) + ((bufr.region + 1) * 100) + dir;
+
+			MPI_Recv_init(bufr.data[dir], bufr.counts[n], L_MPI_POP_TYPE, 
+				neighbour_rank[mpi_getOpposite(dir)], TAG, world_comm, &bufr.requests[n]);
+		}
+	}
+
+	// The same messages may be exchanged by a neighbourhood collective
+	mpi_buildNeighbourGraphs();
+
+#ifdef L_MPI_SHARED_HALO
+	mpi_buildSharedHalo();
+#endif
+
+}
+
+// ************************************************************************* //
+/// \brief	Set up the neighbourhood collective exchange of every grid.
+///
+///			The ranks holding each grid are joined by a distributed graph
+///			communicator with one edge per message which is not exchanged 
+///			through shared memory. Must be called by all processes as the 
+///			communicators are created collectively.
+void MpiManager::mpi_buildNeighbourGraphs() {
+
+	MPI_Group world_group;
+	MPI_Comm_group(world_comm, &world_group);
+
+	for (int l = 0; l <= L_NUM_LEVELS; l++)
+	{
+		for (int r = 0; r < L_NUM_REGIONS; r++)
+		{
+			if (l == 0 && r != 0) continue;		// L0 can only be R0
+
+			// Find the buffer info if the grid is on this rank
+			BufferSizeStruct *bufs = nullptr, *bufr = nullptr;
+			for (size_t n = 0; n < buffer_send_info.size(); n++)
+			{
+				if (buffer_send_info[n].level == l && buffer_send_info[n].region == r)
+				{
+					bufs = &buffer_send_info[n];
+					bufr = &buffer_recv_info[n];
+				}
+			}
+
+			// Ranks holding the grid
+			MPI_Comm grid_comm;
+			MPI_Comm_split(world_comm, (bufs != nullptr ? 0 : MPI_UNDEFINED), my_rank, &grid_comm);
+			if (grid_comm == MPI_COMM_NULL) continue;
+
+			// Neighbour at the end of each message in the world and grid communicators
+			std::vector<int> dests(bufs->count), srcs(bufr->count);
+			for (int n = 0; n < bufs->count; n++) dests[n] = neighbour_rank[bufs->dirs[n]];
+			for (int n = 0; n < bufr->count; n++) srcs[n] = neighbour_rank[mpi_getOpposite(bufr->dirs[n])];
+			std::vector<int> grid_dests(dests.size()), grid_srcs(srcs.size());
+			MPI_Group grid_group;
+			MPI_Comm_group(grid_comm, &grid_group);
+			MPI_Group_translate_ranks(world_group, bufs->count, dests.data(), grid_group, grid_dests.data());
+			MPI_Group_translate_ranks(world_group, bufr->count, srcs.data(), grid_group, grid_srcs.data());
+			MPI_Group_free(&grid_group);
+
+			for (int rank : grid_dests)
+			{
+				if (rank == MPI_UNDEFINED)
+					L_ERROR("L" + std::to_string(l) + "R" + std::to_string(r) + 
+						" -- Sending halo to a rank which does not hold the grid. Exiting.", GridUtils::logfile);
+			}
+
+			/* Messages between the same pair of ranks are matched in the order
+			 * of their edges. Both sides list them by direction so each send 
+			 * meets the receive of the same direction. */
+			MPI_Dist_graph_create_adjacent(grid_comm, 
+				bufr->count, grid_srcs.data(), MPI_UNWEIGHTED, 
+				bufs->count, grid_dests.data(), MPI_UNWEIGHTED, 
+				MPI_INFO_NULL, 0, &bufs->graph_comm);
+			bufr->graph_comm = bufs->graph_comm;
+			MPI_Comm_free(&grid_comm);
+		}
+	}
+
+	MPI_Group_free(&world_group);
+
+}
+
+// ************************************************************************* //
+/// \brief	Set up the shared memory halo exchange of every grid.
+///
+///			Each rank holds one segment of a shared window per level and 
+///			region into which it packs its messages to on-node neighbours. 
+///			The segment starts with a table of where the message of each 
+///			direction lies so the neighbours can find it and unpack from it
+///			directly. Must be called by all processes as window creation is
+///			collective over the ranks of the node.
+void MpiManager::mpi_buildSharedHalo() {
+
+	// Rank of this process in the node
+	int node_rank;
+	MPI_Comm_rank(node_comm, &node_rank);
+
+	for (int l = 0; l <= L_NUM_LEVELS; l++)
+	{
+		for (int r = 0; r < L_NUM_REGIONS; r++)
+		{
+			if (l == 0 && r != 0) continue;		// L0 can only be R0
+
+			// Find the buffer info if the grid is on this rank
+			BufferSizeStruct *bufs = nullptr, *bufr = nullptr;
+			for (size_t n = 0; n < buffer_send_info.size(); n++)
+			{
+				if (buffer_send_info[n].level == l && buffer_send_info[n].region == r)
+				{
+					bufs = &buffer_send_info[n];
+					bufr = &buffer_recv_info[n];
+				}
+			}
+
+			// Byte offset of the message of each direction after the table
+			long long offsets[L_MPI_DIRS];
+			MPI_Aint bytes = sizeof(offsets);
+			for (int dir = 0; dir < L_MPI_DIRS; dir++) offsets[dir] = -1;
+			for (int n = 0; bufs != nullptr && n < bufs->shared_count; n++)
+			{
+				int dir = bufs->shared_dirs[n];
+				offsets[dir] = bytes;
+				bytes += bufs->size[dir] * halo_vels[dir].size() * sizeof(popType);
+			}
+
+			// Allocate this rank's segment (every rank takes part even without the grid)
+			char *base;
+			MPI_Win win;
+			MPI_Win_allocate_shared(bytes, 1, MPI_INFO_NULL, node_comm, &base, &win);
+			halo_wins.push_back(win);
+			std::memcpy(base, offsets, sizeof(offsets));
+			MPI_Win_fence(0, win);
+
+			if (bufs != nullptr)
+			{
+				bufs->win = win;
+				bufr->win = win;
+
+				// Messages are packed into this rank's segment
+				std::vector<int> receivers;
+				for (int n = 0; n < bufs->shared_count; n++)
+				{
+					int dir = bufs->shared_dirs[n];
+					bufs->data[dir] = reinterpret_cast<popType *>(base + offsets[dir]);
+					receivers.push_back(neighbour_node_rank[dir]);
+				}
+
+				// Messages are unpacked from the segment of the neighbour in the opposite direction
+				std::vector<int> senders;
+				for (int n = 0; n < bufr->shared_count; n++)
+				{
+					int dir = bufr->shared_dirs[n];
+					int src = neighbour_node_rank[mpi_getOpposite(dir)];
+					MPI_Aint src_bytes;
+					int disp_unit;
+					char *src_base;
+					MPI_Win_shared_query(win, src, &src_bytes, &disp_unit, &src_base);
+
+					long long offset;
+					std::memcpy(&offset, src_base + dir * sizeof(offset), sizeof(offset));
+					if (offset < 0)
+					{
+						L_ERROR("L" + std::to_string(l) + "R" + std::to_string(r) + 
+							" -- Rank " + std::to_string(neighbour_rank[mpi_getOpposite(dir)]) + 
+							" has no shared message for direction " + std::to_string(dir) + ". Exiting.", GridUtils::logfile);
+					}
+					bufr->data[dir] = reinterpret_cast<popType *>(src_base + offset);
+					senders.push_back(src);
+				}
+
+				/* Synchronise with each neighbour once however many directions it
+				 * shares. This rank reads its own messages without synchronising. */
+				for (std::vector<int> *group : { &receivers, &senders })
+				{
+					std::sort(group->begin(), group->end());
+					group->erase(std::unique(group->begin(), group->end()), group->end());
+					group->erase(std::remove(group->begin(), group->end(), node_rank), group->end());
+				}
+				if (!receivers.empty())
+					MPI_Group_incl(node_group, static_cast<int>(receivers.size()), receivers.data(), &bufs->shared_group);
+				if (!senders.empty())
+					MPI_Group_incl(node_group, static_cast<int>(senders.size()), senders.data(), &bufr->shared_group);
+			}
+
+			MPI_Win_fence(MPI_MODE_NOSUCCEED, win);
+		}
+	}
+
+}
+
+// ************************************************************************* //
+/// \brief	Free the persistent halo exchange of every grid.
+///
+///			Frees the persistent requests, graph communicators and any shared
+///			memory windows. Must be called by all processes before the buffer
+///			information is discarded and while no exchange is in progress.
+void MpiManager::mpi_freeHaloRequests() {
+
+	// Graph communicators (shared by the sender and receiver info)
+	for (BufferSizeStruct& bufs : buffer_send_info)
+	{
+		if (bufs.graph_comm != MPI_COMM_NULL) MPI_Comm_free(&bufs.graph_comm);
+	}
+
+	for (std::vector<BufferSizeStruct> *info : { &buffer_send_info, &buffer_recv_info })
+	{
+		for (BufferSizeStruct& buf : *info)
+		{
+			buf.graph_comm = MPI_COMM_NULL;
+			for (int n = 0; n < buf.count; n++) MPI_Request_free(&buf.requests[n]);
+			buf.count = 0;
+			if (buf.shared_group != MPI_GROUP_EMPTY) MPI_Group_free(&buf.shared_group);
+			buf.shared_group = MPI_GROUP_EMPTY;
+			buf.shared_count = 0;
+		}
+	}
+
+	// Shared memory windows
+	for (MPI_Win& win : halo_wins) MPI_Win_free(&win);
+	halo_wins.clear();
+
+}
+
 // ************************************************************************* //
 /// \brief	Helper method to find opposite direction in MPI topology.
 ///
@@ -1360,11 +1879,16 @@ void MpiManager::mpi_SDReconstructSolution(SDData& solutionData, std::vector<int
 }
 
 // ************************************************************************* //
-/// \brief	Populate the active cell counts for the given block configuration.
+/// \brief	Populate the predicted costs for the given block configuration.
 ///
-///			Imbalance measured as the difference between the heaviest and 
-///			lightest block as a percentage of the heaviest. The load imbalance
-///			information is used to update the structure provided.
+///			The cost of a block is the cost of a coarse time step of all its
+///			levels, each level doing 2^level sub-cycles. Imbalance measured as 
+///			the difference between the heaviest and lightest block as a 
+///			percentage of the heaviest. As the ranks exchange halos on every
+///			sub-cycle of a level, each level proceeds at the pace of its 
+///			slowest rank so the critical path is the sum over the levels of 
+///			the heaviest block on that level. The load imbalance information 
+///			is used to update the structure provided.
 ///
 ///	\param[out]	load			load imbalance information structure.
 ///	\param		solutionData	structure to hold SD information.
@@ -1372,11 +1896,11 @@ void MpiManager::mpi_SDReconstructSolution(SDData& solutionData, std::vector<int
 void MpiManager::mpi_SDComputeImbalance(LoadImbalanceData& load,
 	SDData& solutionData, std::vector<int>& numCores)
 {
-	size_t count = 0;
-	size_t countMax = 0;
-	size_t countMin = std::numeric_limits<size_t>::max();
+	double costMax = 0.0;
+	double costMin = std::numeric_limits<double>::max();
+	std::vector<double> levelMax(L_NUM_LEVELS + 1, 0.0);
 
-	// Construct bounds for each block and then find active cell count from grid manager
+	// Construct bounds for each block and then find the predicted cost
 	double bounds[6];
 	for (int i = 0; i < numCores[eXDirection]; ++i)
 	{
@@ -1392,28 +1916,341 @@ void MpiManager::mpi_SDComputeImbalance(LoadImbalanceData& load,
 				bounds[eZMin] = solutionData.ZSol[k];
 				bounds[eZMax] = solutionData.ZSol[k + 1];
 
-				// Get active operation count
-				count = GridManager::getInstance()->getActiveCellCount(&bounds[0], true);
+				// Add up the sub-cycles of each level
+				double cost = 0.0;
+				for (int lev = 0; lev < L_NUM_LEVELS + 1; ++lev)
+				{
+					double levelCost = mpi_SDGetBlockCost(&bounds[0], lev) * pow(2, lev);
+					levelMax[lev] = std::max(levelMax[lev], levelCost);
+					cost += levelCost;
+				}
 
 				// Update the extremes
-				if (count > countMax)
+				if (cost > costMax)
 				{
-					countMax = count;
+					costMax = cost;
 					load.heaviestBlock[eXDirection] = i;
 					load.heaviestBlock[eYDirection] = j;
 					load.heaviestBlock[eZDirection] = k;
 				}
-				if (count < countMin) countMin = count;
+				if (cost < costMin) costMin = cost;
 
 			}
 		}
 	}
 
 	// Update load imbalance
-	load.loadImbalance = 
-		std::abs(static_cast<double>(countMax) - static_cast<double>(countMin)) * 100.0 / static_cast<double>(countMax);
-	load.heaviestOps = countMax;
+	load.loadImbalance = (costMax - costMin) * 100.0 / costMax;
+	load.heaviestOps = costMax;
+	load.criticalPath = std::accumulate(levelMax.begin(), levelMax.end(), 0.0);
+
+}
+
+// ************************************************************************* //
+/// \brief	Predicted cost of a time step of one level within a block.
+///
+///			Sums the calibrated cost map if one was read. Otherwise every 
+///			active cell of the level, i.e. not covered by a finer level, costs
+///			the same.
+///
+///	\param	bounds	pointer to an array containing the bounds of the block.
+///	\param	lev		grid level.
+///	\returns		predicted cost of one time step of the level.
+double MpiManager::mpi_SDGetBlockCost(double *bounds, int lev)
+{
+	GridManager *gm = GridManager::getInstance();
+
+	if (!costTable.empty())
+	{
+		// Snap the bounds to L0 sites
+		const int lims[3] = { L_N, L_M, L_K };
+		int lo[3] = { 0, 0, 0 };
+		int hi[3] = { 1, 1, 1 };
+		for (int d = 0; d < L_DIMS; ++d)
+		{
+			lo[d] = std::min(std::max(static_cast<int>(std::round(bounds[2 * d] / L_COARSE_SITE_WIDTH)), 0), lims[d]);
+			hi[d] = std::min(std::max(static_cast<int>(std::round(bounds[2 * d + 1] / L_COARSE_SITE_WIDTH)), lo[d]), lims[d]);
+		}
+
+		// Inclusion-exclusion on the summed-area table of the level
+		const double *table = &costTable[lev * (L_N + 1) * (L_M + 1) * (L_K + 1)];
+		double cost = 0.0;
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			int ijk[3];
+			int sign = 1;
+			for (int d = 0; d < 3; ++d)
+			{
+				bool bHigh = ((corner >> d) & 1) != 0;
+				ijk[d] = bHigh ? hi[d] : lo[d];
+				if (!bHigh) sign = -sign;
+			}
+			cost += sign * table[ijk[2] + ijk[1] * (L_K + 1) + ijk[0] * (L_K + 1) * (L_M + 1)];
+		}
+		return cost;
+	}
+
+	// Active cells of this level
+	long cells = 0;
+	for (int reg = 0; reg < L_NUM_REGIONS; ++reg)
+	{
+		// L0 can only be region 0
+		if (lev == 0 && reg != 0) continue;
+		cells += gm->getCellCount(lev, reg, bounds);
+		if (lev < L_NUM_LEVELS)
+			cells -= gm->getCellCount(lev + 1, reg, bounds) / static_cast<long>(pow(2, L_DIMS));
+	}
+	return static_cast<double>(cells);
+}
+
+// ************************************************************************* //
+/// \brief	Read a cost map written by an earlier profiling run.
+///
+///			The map gives the calibrated cost of a time step of each level 
+///			within each L0 site and is stored as a summed-area table per level 
+///			so the cost of any block may be found in constant time. If the map
+///			is missing or was written for another grid it is ignored and smart
+///			decomposition falls back to counting active cells.
+void MpiManager::mpi_SDReadCostMap()
+{
+	std::ifstream file;
+	file.open("./input/costmap.in", std::ios::in);
+	if (!file.is_open())
+	{
+		L_INFO("No cost map found. Load model will count active cells.", GridUtils::logfile);
+		return;
+	}
+
+	// Check the map matches this grid
+	int n, m, k, levels;
+	file >> n >> m >> k >> levels;
+	if (n != L_N || m != L_M || k != L_K || levels != L_NUM_LEVELS)
+	{
+		L_WARN("Cost map was written for a different grid and will be ignored.", GridUtils::logfile);
+		return;
+	}
+
+	// Read the costs into the tables offset by one in each direction
+	const size_t levelSize = (L_N + 1) * (L_M + 1) * (L_K + 1);
+	costTable.assign(levelSize * (L_NUM_LEVELS + 1), 0.0);
+	int i, j, lev;
+	double cost;
+	while (file >> i >> j >> k >> lev >> cost)
+	{
+		if (i < 0 || i >= L_N || j < 0 || j >= L_M || k < 0 || k >= L_K || lev < 0 || lev > L_NUM_LEVELS) continue;
+		costTable[lev * levelSize + (k + 1) + (j + 1) * (L_K + 1) + (i + 1) * (L_K + 1) * (L_M + 1)] += cost;
+	}
+	file.close();
+
+	// Prefix sums in each direction in turn
+	for (lev = 0; lev < L_NUM_LEVELS + 1; ++lev)
+	{
+		double *table = &costTable[lev * levelSize];
+		for (i = 1; i < L_N + 1; ++i)
+			for (j = 0; j < L_M + 1; ++j)
+				for (k = 0; k < L_K + 1; ++k)
+					table[k + j * (L_K + 1) + i * (L_K + 1) * (L_M + 1)] += table[k + j * (L_K + 1) + (i - 1) * (L_K + 1) * (L_M + 1)];
+		for (i = 0; i < L_N + 1; ++i)
+			for (j = 1; j < L_M + 1; ++j)
+				for (k = 0; k < L_K + 1; ++k)
+					table[k + j * (L_K + 1) + i * (L_K + 1) * (L_M + 1)] += table[k + (j - 1) * (L_K + 1) + i * (L_K + 1) * (L_M + 1)];
+		for (i = 0; i < L_N + 1; ++i)
+			for (j = 0; j < L_M + 1; ++j)
+				for (k = 1; k < L_K + 1; ++k)
+					table[k + j * (L_K + 1) + i * (L_K + 1) * (L_M + 1)] += table[(k - 1) + j * (L_K + 1) + i * (L_K + 1) * (L_M + 1)];
+	}
+
+	L_INFO("Cost map read. Load model will use calibrated costs.", GridUtils::logfile);
+}
+
+// ************************************************************************* //
+/// \brief	Calibrate the cost of each site type and write a cost map.
+///
+///			Every grid on every rank gives one sample of its time-averaged 
+///			kernel time against the number of sites of each type it owns and 
+///			updates, IBM support sites counting as a type of their own. Sites
+///			the kernel skips, such as those of dropped refinement blocks, add
+///			nothing, so the map carries the trimmed regions into the next 
+///			decomposition. The cost per site of
+///			each type is fitted to the samples by least squares, regularised 
+///			towards prior estimates so types with few samples keep sensible 
+///			costs. The cost map then holds the fitted cost of the sites of each
+///			level within each L0 site and is written to the output directory 
+///			for smart decomposition to read on the next run.
+///
+///	\param	grid_man	pointer to the grid manager.
+void MpiManager::mpi_profileLoad(GridManager* const grid_man)
+{
+	// Site types plus IBM support sites
+	const int supportType = eSlip + 1;
+	const int numTypes = supportType + 1;
+	const int numSamples = L_NUM_LEVELS * L_NUM_REGIONS + 1;
+	const int rowSize = numTypes + 1;
+
+	// Prior estimates of the cost per site of each type relative to fluid
+	double prior[numTypes];
+	prior[eSolid] = 0.1;
+	prior[eFluid] = 1.0;
+	prior[eRefined] = 0.1;
+	prior[eTransitionToCoarser] = 0.8;
+	prior[eTransitionToFiner] = 1.5;
+	prior[eBFL] = 2.0;
+	prior[eVelocity] = 0.2;
+	prior[ePressure] = 1.2;
+	prior[eSlip] = 1.5;
+	prior[supportType] = 2.0;
+
+	// Visit each owned site the kernel updates and each support site of a grid
+	auto visitSites = [](GridObj *g, std::function<void(int, double, double, double)> visit)
+	{
+		auto visitSite = [&](int i, int j, int k)
+		{
+#ifdef L_BUILD_FOR_MPI
+			if (GridUtils::isOnRecvLayer(g->XPos[i], g->YPos[j], g->ZPos[k])) return;
+#endif
+			visit(g->LatTyp(i, j, k, g->M_lim, g->K_lim), g->XPos[i], g->YPos[j], g->ZPos[k]);
+		};
+
+		// Sites of dropped refinement blocks or without sparse storage are not updated
+		if (g->bSparse)
+		{
+			for (size_t n = 0; n < g->sparseSites.size(); n += 3)
+				visitSite(g->sparseSites[n], g->sparseSites[n + 1], g->sparseSites[n + 2]);
+		}
+		else
+		{
+			for (size_t n = 0; n < g->tiles.size(); n += 6)
+			{
+				for (int i = g->tiles[n]; i < g->tiles[n + 1]; ++i)
+				{
+					for (int j = g->tiles[n + 2]; j < g->tiles[n + 3]; ++j)
+					{
+						for (int k = g->tiles[n + 4]; k < g->tiles[n + 5]; ++k)
+							visitSite(i, j, k);
+					}
+				}
+			}
+		}
+#ifdef L_IBM_ON
+		ObjectManager *objMan = ObjectManager::getInstance();
+		for (auto& body : objMan->iBody)
+		{
+			if (body._Owner != g) continue;
+			for (auto m : body.validMarkers)
+			{
+				for (size_t s = 0; s < body.markers[m].supp_x.size(); ++s)
+					visit(supportType, body.markers[m].supp_x[s], body.markers[m].supp_y[s], body.markers[m].supp_z[s]);
+			}
+		}
+#endif
+	};
+
+	// One sample row per grid: site counts followed by the kernel time
+	std::vector<double> samples(numSamples * rowSize, 0.0);
+	for (int lev = 0; lev < L_NUM_LEVELS + 1; ++lev)
+	{
+		for (int reg = 0; reg < L_NUM_REGIONS; ++reg)
+		{
+			if (lev == 0 && reg != 0) continue;
+			GridObj *g = nullptr;
+			GridUtils::getGrid(grid_man->Grids, lev, reg, g);
+			if (g == nullptr) continue;
+
+			double *row = &samples[(lev == 0 ? 0 : 1 + (lev - 1) + reg * L_NUM_LEVELS) * rowSize];
+			visitSites(g, [row](int type, double, double, double) { row[type] += 1.0; });
+			row[numTypes] = g->timeav_timestep;
+		}
+	}
+
+	// Gather samples from all ranks
+	std::vector<double> allSamples(my_rank == 0 ? numSamples * rowSize * num_ranks : 0);
+	MPI_Gather(&samples[0], numSamples * rowSize, MPI_DOUBLE,
+		allSamples.data(), numSamples * rowSize, MPI_DOUBLE, 0, world_comm);
+
+	std::vector<double> weights(numTypes, 0.0);
+	if (my_rank == 0)
+	{
+		// Normal equations
+		std::vector<std::vector<double>> AtA(numTypes, std::vector<double>(numTypes, 0.0));
+		std::vector<double> Atb(numTypes, 0.0);
+		double totalTime = 0.0, totalPrior = 0.0;
+		for (int r = 0; r < numSamples * num_ranks; ++r)
+		{
+			const double *row = &allSamples[r * rowSize];
+			for (int a = 0; a < numTypes; ++a)
+			{
+				for (int b = 0; b < numTypes; ++b) AtA[a][b] += row[a] * row[b];
+				Atb[a] += row[a] * row[numTypes];
+				totalPrior += row[a] * prior[a];
+			}
+			totalTime += row[numTypes];
+		}
+
+		// Regularise towards the priors scaled to the measured times
+		double scale = (totalPrior > 0.0) ? totalTime / totalPrior : 0.0;
+		double maxDiag = 0.0;
+		for (int a = 0; a < numTypes; ++a) maxDiag = std::max(maxDiag, AtA[a][a]);
+		for (int a = 0; a < numTypes; ++a)
+		{
+			double lambda = 0.1 * AtA[a][a] + 1.0e-6 * maxDiag;
+			if (lambda == 0.0) lambda = 1.0;
+			AtA[a][a] += lambda;
+			Atb[a] += lambda * scale * prior[a];
+		}
+		weights = GridUtils::solveLinearSystem(AtA, Atb);
+		for (auto& w : weights) w = std::max(w, 0.0);
+
+		// Report relative to a fluid site
+		std::string msg = "Fitted site costs relative to fluid:";
+		for (int a = 0; a < numTypes; ++a)
+			msg += " " + std::to_string(weights[eFluid] > 0.0 ? weights[a] / weights[eFluid] : 0.0);
+		L_INFO(msg, GridUtils::logfile);
+	}
+	MPI_Bcast(weights.data(), numTypes, MPI_DOUBLE, 0, world_comm);
 
+	// Accumulate the cost of each level within each L0 site
+	const size_t levelSize = L_N * L_M * L_K;
+	std::vector<double> costMap(levelSize * (L_NUM_LEVELS + 1), 0.0);
+	for (int lev = 0; lev < L_NUM_LEVELS + 1; ++lev)
+	{
+		for (int reg = 0; reg < L_NUM_REGIONS; ++reg)
+		{
+			if (lev == 0 && reg != 0) continue;
+			GridObj *g = nullptr;
+			GridUtils::getGrid(grid_man->Grids, lev, reg, g);
+			if (g == nullptr) continue;
+
+			double *levelMap = &costMap[lev * levelSize];
+			visitSites(g, [&](int type, double x, double y, double z)
+			{
+				int i = std::min(std::max(static_cast<int>(x / L_COARSE_SITE_WIDTH), 0), L_N - 1);
+				int j = std::min(std::max(static_cast<int>(y / L_COARSE_SITE_WIDTH), 0), L_M - 1);
+				int k = std::min(std::max(static_cast<int>(z / L_COARSE_SITE_WIDTH), 0), L_K - 1);
+				levelMap[k + j * L_K + i * L_K * L_M] += weights[type];
+			});
+		}
+	}
+
+	// Sum onto master and write out
+	std::vector<double> globalMap(my_rank == 0 ? costMap.size() : 0);
+	MPI_Reduce(costMap.data(), globalMap.data(), static_cast<int>(costMap.size()), MPI_DOUBLE, MPI_SUM, 0, world_comm);
+	if (my_rank == 0)
+	{
+		std::ofstream file;
+		file.open(GridUtils::path_str + "/costmap.out", std::ios::out);
+		file << L_N << " " << L_M << " " << L_K << " " << L_NUM_LEVELS << std::endl;
+		for (int lev = 0; lev < L_NUM_LEVELS + 1; ++lev)
+			for (int i = 0; i < L_N; ++i)
+				for (int j = 0; j < L_M; ++j)
+					for (int k = 0; k < L_K; ++k)
+					{
+						double cost = globalMap[lev * levelSize + k + j * L_K + i * L_K * L_M];
+						if (cost > 0.0) file << i << " " << j << " " << k << " " << lev << " " << cost << std::endl;
+					}
+		file.close();
+
+		L_INFO("Cost map written. Copy it to input/costmap.in to use it for smart decomposition.", GridUtils::logfile);
+	}
 }
 
 // ************************************************************************* //
@@ -1506,7 +2343,8 @@ MpiManager::LoadImbalanceData MpiManager::mpi_smartDecompose(double dh, std::vec
 		// Update uniform decomposition quantity
 		load.uniImbalance = load.loadImbalance;
 #ifndef L_MPI_TOPOLOGY_REPORT
-		L_INFO("Uniform decomposition produces an imbalance of " + std::to_string(load.uniImbalance) + "%.", GridUtils::logfile);
+		L_INFO("Uniform decomposition produces an imbalance of " + std::to_string(load.uniImbalance) + 
+			"% and a predicted critical path of " + std::to_string(load.criticalPath) + ".", GridUtils::logfile);
 #endif
 
 		// Temporaries
@@ -1579,10 +2417,12 @@ MpiManager::LoadImbalanceData MpiManager::mpi_smartDecompose(double dh, std::vec
 			// Obtain new imbalance under the adjusted delta
 			mpi_SDComputeImbalance(tmpLoad, tempData, numCores);
 
-			// If better than current solution, update
-			if (tmpLoad.loadImbalance <= load.loadImbalance)
+			// If the slowest ranks finish sooner than with the current solution, update
+			if (tmpLoad.criticalPath <= load.criticalPath)
 			{
 				load.loadImbalance = tmpLoad.loadImbalance;
+				load.heaviestOps = tmpLoad.heaviestOps;
+				load.criticalPath = tmpLoad.criticalPath;
 				solutionData.XSol = tempData.XSol;
 				solutionData.YSol = tempData.YSol;
 				solutionData.ZSol = tempData.ZSol;
@@ -1789,6 +2629,38 @@ void MpiManager::mpi_setSubGridDepth()
 	}
 }
 
+// ************************************************************************** //
+/// \brief	Rebuild the grid-dependent MPI data after the hierarchy changes.
+///
+///			Buffer sizes depend on the site labels and the communicators on 
+///			which ranks hold each sub-grid, so both are recomputed. Must be 
+///			called by all processes.
+///
+///	\param	grid_man	pointer to non-null grid manager.
+void MpiManager::mpi_rebuildGridInfo(GridManager* const grid_man)
+{
+	// Buffer sizes
+	mpi_freeHaloRequests();
+	buffer_send_info.clear();
+	buffer_recv_info.clear();
+	mpi_buffer_size();
+
+	// Writable data and sub-grid communicators
+	for (MPI_Comm &comm : subGrid_comm)
+	{
+		if (comm != MPI_COMM_NULL) MPI_Comm_free(&comm);
+	}
+	grid_man->p_data.clear();
+	mpi_buildCommunicators(grid_man);
+
+	// Level communicators
+	for (MPI_Comm &comm : lev_comm)
+	{
+		if (comm != MPI_COMM_NULL) MPI_Comm_free(&comm);
+	}
+	mpi_setSubGridDepth();
+}
+
 // *****************************************************************************
 ///	\brief	Maps rank numbers from level communicator to world communcator
 ///
@@ -29,12 +29,13 @@
 ///
 ///			A halo consists of a receiver (outer) and sender (inner) layer. 
 ///			This method computes the size of the receiver layers in each 
-///			communication direction (MPI directions).
+///			communication direction (MPI directions) and records their sites in
+///			the order they are held in the buffers.
 ///
 /// \param	g	grid being inspected.
 void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 
-	int count, i, j, k, dir;	// Local counters
+	int i, j, k, dir;	// Local counters
 	// Local grid sizes
 	int N_lim = static_cast<int>(g->N_lim), M_lim = static_cast<int>(g->M_lim)
 #if (L_DIMS == 3)
@@ -74,8 +75,9 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	*/
 	for (dir = 0; dir < L_MPI_DIRS; dir++)  {
 
-		// Reset the site counter
-		count = 0;
+		// Sites of this direction in buffer order
+		std::vector<int> &sites = buffer_recv_info.back().sites[dir];
+		sites.clear();
 
 		// Switch based on direction
 		switch (dir)
@@ -100,7 +102,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -128,7 +130,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 					
@@ -156,7 +158,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -184,7 +186,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -212,7 +214,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -241,7 +243,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -269,7 +271,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -297,7 +299,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 	#endif
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -327,7 +329,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -352,7 +354,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -377,7 +379,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -402,7 +404,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -427,7 +429,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -452,7 +454,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -477,7 +479,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -502,7 +504,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -527,7 +529,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -552,7 +554,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -577,7 +579,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -602,7 +604,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -627,7 +629,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -652,7 +654,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -677,7 +679,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -702,7 +704,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -727,7 +729,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -752,7 +754,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 									(GridUtils::isOnRecvLayer(g->ZPos[k],eZMax))
 							) {
 								// Must be suitable receiver site
-								count++;
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -767,7 +769,7 @@ void MpiManager::mpi_buffer_size_recv(GridObj* const g) {
 		}
 
 		// Store the count of sites in the MpiManager buffer_info structure
-		buffer_recv_info.back().size[dir] = count;
+		buffer_recv_info.back().size[dir] = static_cast<int>(sites.size() / 3);
 	}
 
 }
\ No newline at end of file
@@ -29,12 +29,13 @@
 ///
 ///			A halo consists of a receiver (outer) and sender (inner) layer. 
 ///			This method computes the size of the sender layers in each 
-///			communication direction (MPI directions).
+///			communication direction (MPI directions) and records their sites in
+///			the order they are held in the buffers.
 ///
 /// \param	g	grid being inspected.
 void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 	
-	int count, i, j, k, dir;	// Local counters
+	int i, j, k, dir;	// Local counters
 	// Local grid sizes
 	int N_lim = static_cast<int>(g->N_lim), M_lim = static_cast<int>(g->M_lim)
 #if (L_DIMS == 3)
@@ -74,8 +75,9 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 	*/
 	for (dir = 0; dir < L_MPI_DIRS; dir++)  {
 
-		// Reset the site counter
-		count = 0;
+		// Sites of this direction in buffer order
+		std::vector<int> &sites = buffer_send_info.back().sites[dir];
+		sites.clear();
 
 		// Switch based on direction
 		switch (dir)
@@ -100,8 +102,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 #endif
 							) {
 
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -126,8 +128,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 								(!GridUtils::isOnRecvLayer(g->ZPos[k],eZMax) && !GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 #endif
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -152,8 +154,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 								(!GridUtils::isOnRecvLayer(g->ZPos[k],eZMax) && !GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 #endif
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -178,8 +180,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 								(!GridUtils::isOnRecvLayer(g->ZPos[k],eZMax) && !GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 #endif
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -204,8 +206,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 								(!GridUtils::isOnRecvLayer(g->ZPos[k],eZMax) && !GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 #endif
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -231,8 +233,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 								(!GridUtils::isOnRecvLayer(g->ZPos[k],eZMax) && !GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 #endif
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -257,8 +259,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 								(!GridUtils::isOnRecvLayer(g->ZPos[k],eZMax) && !GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 #endif
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -283,8 +285,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 								(!GridUtils::isOnRecvLayer(g->ZPos[k],eZMax) && !GridUtils::isOnRecvLayer(g->ZPos[k],eZMin))
 #endif
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -311,8 +313,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(!GridUtils::isOnRecvLayer(g->YPos[j],eYMin) && !GridUtils::isOnRecvLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -334,8 +336,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(!GridUtils::isOnRecvLayer(g->YPos[j],eYMin) && !GridUtils::isOnRecvLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -357,8 +359,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(!GridUtils::isOnRecvLayer(g->YPos[j],eYMin) && !GridUtils::isOnRecvLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -380,8 +382,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(!GridUtils::isOnRecvLayer(g->YPos[j],eYMin) && !GridUtils::isOnRecvLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -403,8 +405,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -426,8 +428,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMin)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -449,8 +451,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -472,8 +474,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMin)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -495,8 +497,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -518,8 +520,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMin)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -541,8 +543,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(!GridUtils::isOnRecvLayer(g->YPos[j],eYMin) && !GridUtils::isOnRecvLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -564,8 +566,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(!GridUtils::isOnRecvLayer(g->YPos[j],eYMin) && !GridUtils::isOnRecvLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -587,8 +589,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMin)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -610,8 +612,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -633,8 +635,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMin)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -656,8 +658,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -679,8 +681,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMin)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMax))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -702,8 +704,8 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 									(GridUtils::isOnSenderLayer(g->YPos[j],eYMax)) &&
 									(GridUtils::isOnSenderLayer(g->ZPos[k],eZMin))
 							) {
-								// Must be a site to pass in MPI so increment counter
-								count++;
+								// Must be a site to pass in MPI so add it to the list
+								sites.insert(sites.end(), { i, j, k });
 							}
 						}
 
@@ -718,7 +720,7 @@ void MpiManager::mpi_buffer_size_send(GridObj* const g) {
 		}
 			
 		// Store the count of sites in the MpiManager buffer_info structure
-		buffer_send_info.back().size[dir] = count;				
+		buffer_send_info.back().size[dir] = static_cast<int>(sites.size() / 3);
 
 	}
 
@@ -23,6 +23,9 @@
 #include "../inc/stdafx.h"
 #include "../inc/ObjectManager.h"
 #include "../inc/GridObj.h"
+#ifdef L_ENABLE_OPENMP
+#include <omp.h>
+#endif
 
 
 // Static declarations
@@ -113,6 +116,13 @@ void ObjectManager::computeLiftDrag(int i, int j, int k, GridObj *g) {
 		// Declare some local stores
 		double contrib_x = 0.0, contrib_y = 0.0, contrib_z = 0.0;
 
+		// Accumulate into the forces of this thread
+#ifdef L_ENABLE_OPENMP
+		std::vector<double> &forces = threadMomexForces[omp_get_thread_num()];
+#else
+		std::vector<double> &forces = threadMomexForces[0];
+#endif
+
 		// Loop over directions from solid site
 		for (int n = 0; n < L_NUM_VELS; n++)
 		{
@@ -145,15 +155,15 @@ void ObjectManager::computeLiftDrag(int i, int j, int k, GridObj *g) {
 				 * appropriate direction.
 				 */
 				 // Store contribution in this direction
-				contrib_x += 2.0 * c[eXDirection][n_opp] * g->f(xdest, ydest, zdest, n_opp, M_lim, K_lim, L_NUM_VELS);
-				contrib_y += 2.0 * c[eYDirection][n_opp] * g->f(xdest, ydest, zdest, n_opp, M_lim, K_lim, L_NUM_VELS);
-				contrib_z += 2.0 * c[eZDirection][n_opp] * g->f(xdest, ydest, zdest, n_opp, M_lim, K_lim, L_NUM_VELS);
+				contrib_x += 2.0 * c[eXDirection][n_opp] * g->f[g->LBM_fIdx(xdest, ydest, zdest, n_opp)];
+				contrib_y += 2.0 * c[eYDirection][n_opp] * g->f[g->LBM_fIdx(xdest, ydest, zdest, n_opp)];
+				contrib_z += 2.0 * c[eZDirection][n_opp] * g->f[g->LBM_fIdx(xdest, ydest, zdest, n_opp)];
 			}
 			
 			// Add the total contribution of every direction of this site to the body forces
-			bbbForceOnObjectX += contrib_x;
-			bbbForceOnObjectY += contrib_y;
-			bbbForceOnObjectZ += contrib_z;
+			forces[eXDirection] += contrib_x;
+			forces[eYDirection] += contrib_y;
+			forces[eZDirection] += contrib_z;
 
 #ifdef L_MOMEX_DEBUG
 			// Write contribution to file for this site
@@ -175,18 +185,26 @@ void ObjectManager::computeLiftDrag(int i, int j, int k, GridObj *g) {
 ///	\param	id			collapsed ijk index for site on which BFL BC is being applied.
 /// \param	g			pointer to grid on which marker resides.
 /// \param	markerID	id of marker on which force is to be updated.
-void ObjectManager::computeLiftDrag(int v, int id, GridObj *g, int markerID)
+/// \param	f_new		post-stream population in direction v at the site.
+void ObjectManager::computeLiftDrag(int v, int id, GridObj *g, int markerID, double f_new)
 {
 	// Get opposite once
 	int v_opp = GridUtils::getOpposite(v);
 
+	// Accumulate into the forces of this thread (marker forces follow the BBB forces)
+#ifdef L_ENABLE_OPENMP
+	double *forces = &threadMomexForces[omp_get_thread_num()][3 * (markerID + 1)];
+#else
+	double *forces = &threadMomexForces[0][3 * (markerID + 1)];
+#endif
+
 	// Similar to BBB but we cannot assume that bounced-back population is the same anymore
-	pBody[0].markers[markerID].forceX +=
-		c[eXDirection][v_opp] * (g->f[v_opp + id * L_NUM_VELS] + g->fNew[v + id * L_NUM_VELS]);
-	pBody[0].markers[markerID].forceY +=
-		c[eYDirection][v_opp] * (g->f[v_opp + id * L_NUM_VELS] + g->fNew[v + id * L_NUM_VELS]);
-	pBody[0].markers[markerID].forceZ +=
-		c[eZDirection][v_opp] * (g->f[v_opp + id * L_NUM_VELS] + g->fNew[v + id * L_NUM_VELS]);
+	forces[eXDirection] +=
+		c[eXDirection][v_opp] * (g->f[g->LBM_popIdx(id, v_opp)] + f_new);
+	forces[eYDirection] +=
+		c[eYDirection][v_opp] * (g->f[g->LBM_popIdx(id, v_opp)] + f_new);
+	forces[eZDirection] +=
+		c[eZDirection][v_opp] * (g->f[g->LBM_popIdx(id, v_opp)] + f_new);
 }
 
 // ************************************************************************* //
@@ -225,6 +243,44 @@ void ObjectManager::resetMomexBodyForces(GridObj * grid)
 			}
 		}
 	}
+
+	// Reset the thread-local forces (one set for the BB bodies then one per marker of the first BFL body)
+	size_t numForces = 3 * (1 + (pBody.empty() ? 0 : pBody[0].markers.size()));
+#ifdef L_ENABLE_OPENMP
+	threadMomexForces.resize(omp_get_max_threads());
+#else
+	threadMomexForces.resize(1);
+#endif
+	for (std::vector<double>& forces : threadMomexForces)
+		forces.assign(numForces, 0.0);
+}
+
+// ************************************************************************* //
+/// \brief	Adds the thread-local momentum exchange forces to the body forces.
+///
+///			Momentum exchange contributions are accumulated per thread during 
+///			the LBM kernel so that the sites can be processed concurrently. 
+///			This must be called once the kernel loop has finished.
+void ObjectManager::sumMomexBodyForces()
+{
+	for (std::vector<double>& forces : threadMomexForces)
+	{
+		// Bounce-back bodies
+		bbbForceOnObjectX += forces[eXDirection];
+		bbbForceOnObjectY += forces[eYDirection];
+		bbbForceOnObjectZ += forces[eZDirection];
+
+		// Markers of the BFL body
+		for (size_t m = 0; m + 1 < forces.size() / 3; ++m)
+		{
+			pBody[0].markers[m].forceX += forces[3 * (m + 1) + eXDirection];
+			pBody[0].markers[m].forceY += forces[3 * (m + 1) + eYDirection];
+			pBody[0].markers[m].forceZ += forces[3 * (m + 1) + eZDirection];
+		}
+
+		// Clear so the forces are only added once
+		std::fill(forces.begin(), forces.end(), 0.0);
+	}
 }
 
 // ************************************************************************* //
@@ -693,9 +693,10 @@ void ObjectManager::ibm_updateMacroscopic(int level) {
 	// Get rank
 	int rank = GridUtils::safeGetRank();
 
-	// Grid indices and type
+	// Grid indices, type and populations
 	int idx, jdx, kdx, id;
 	eType type_local;
+	double f_local[L_NUM_VELS];
 
 	// First do all support points that belong to markers that this rank owns
 	// Loop through all IBM bodies
@@ -720,8 +721,9 @@ void ObjectManager::ibm_updateMacroscopic(int level) {
 						id = kdx + jdx * iBody[ib]._Owner->K_lim + idx * iBody[ib]._Owner->K_lim * iBody[ib]._Owner->M_lim;
 						type_local = iBody[ib]._Owner->LatTyp[id];
 
-						// Update macroscopic value at this site
-						iBody[ib]._Owner->_LBM_macro_opt(idx, jdx, kdx, id, type_local);
+						// Update macroscopic value at this site from post-stream populations
+						iBody[ib]._Owner->_LBM_loadStreamed_opt(idx, jdx, kdx, id, f_local);
+						iBody[ib]._Owner->_LBM_macro_opt(idx, jdx, kdx, id, type_local, f_local);
 					}
 				}
 			}
@@ -753,8 +755,9 @@ void ObjectManager::ibm_updateMacroscopic(int level) {
 			id = kdx + jdx * iBody[ib]._Owner->K_lim + idx * iBody[ib]._Owner->K_lim * iBody[ib]._Owner->M_lim;
 			type_local = iBody[ib]._Owner->LatTyp[id];
 
-			// Update macroscopic value at this site
-			iBody[ib]._Owner->_LBM_macro_opt(idx, jdx, kdx, id, type_local);
+			// Update macroscopic value at this site from post-stream populations
+			iBody[ib]._Owner->_LBM_loadStreamed_opt(idx, jdx, kdx, id, f_local);
+			iBody[ib]._Owner->_LBM_macro_opt(idx, jdx, kdx, id, type_local, f_local);
 		}
 	}
 #endif
@@ -288,6 +288,22 @@ int main( int argc, char* argv[] )
 
 #endif
 
+#ifdef L_BLOCK_REFINEMENT
+	// Trim the refined regions to the geometry now all bodies are labelled
+	Grids->LBM_initRefinementBlocks();
+#endif
+
+	// Build boundary link lists now all site labels are known
+	Grids->LBM_initBoundaryLinks();
+
+#ifdef L_SPARSE_STORAGE
+	// Compact population storage now all site labels are known
+	Grids->LBM_initSparseStorage();
+#endif
+
+	// Place the fields now the site loop of every grid is final
+	Grids->LBM_initFirstTouch();
+
 
 	/*
 	****************************************************************************
@@ -341,6 +357,9 @@ int main( int argc, char* argv[] )
 	// Compute load balance information
 	mpim->mpi_updateLoadInfo(gm);
 
+	// Choose how halos are exchanged
+	mpim->mpi_setHaloExchange(argc, argv);
+
 #endif
 
 	// Write out t = 0
@@ -404,6 +423,9 @@ int main( int argc, char* argv[] )
 
 #ifdef L_ENABLE_OPENMP
 	L_WARN("OpenMP support enabled -- currently experimental!", GridUtils::logfile);
+#ifdef L_LOG_THREAD_AFFINITY
+	GridUtils::logThreadAffinity();
+#endif
 #endif
 	
 	L_INFO("Initialising LBM time-stepping...", GridUtils::logfile);
@@ -427,6 +449,7 @@ int main( int argc, char* argv[] )
 #ifdef L_SHOW_TIME_TO_COMPLETE
 		// Start clock for timing outer loop
 		t_start = clock();
+		int t_loop = Grids->t;
 #endif
 		if ((Grids->t + 1) % L_GRID_OUT_FREQ == 0 && rank == 0)
 			std::cout << "\rTime Step " << Grids->t + 1 << " of " << L_TOTAL_TIMESTEPS << " ------>" << std::flush;
@@ -436,7 +459,29 @@ int main( int argc, char* argv[] )
 		// Launch LBM Kernel //
 		///////////////////////
 
+#ifdef L_TEMPORAL_BLOCKING
+		Grids->LBM_multiBlocked_opt();	// Advance several time steps per sweep of the top-level grid
+#elif defined L_CONCURRENT_GRIDS
+		Grids->LBM_multiConcurrent_opt();	// Advance the grid hierarchy a level at a time with shared work lists
+#else
 		Grids->LBM_multi_opt();		// Launch LBM kernel on top-level grid
+#endif
+
+#if (defined L_BUILD_FOR_MPI && defined L_MPI_PROFILE_LOAD)
+		// Calibrate the load model once the kernel timings have settled
+		static bool bProfiled = false;
+		if (!bProfiled && Grids->t >= L_MPI_PROFILE_STEPS)
+		{
+			mpim->mpi_profileLoad(gm);
+			bProfiled = true;
+		}
+#endif
+
+#ifdef L_ADAPTIVE_REFINEMENT
+		// Move the refined regions to follow the flow
+		if (Grids->t % L_AMR_FREQ == 0)
+			Grids->LBM_adaptRefinement();
+#endif
 
 
 		///////////////
@@ -561,7 +606,7 @@ int main( int argc, char* argv[] )
 
 #ifdef L_SHOW_TIME_TO_COMPLETE
 		// Update outer loop time (inc. effects of writing out for accuracy)
-		outer_loop_time *= Grids->t - 1;
+		outer_loop_time *= t_loop;
 		outer_loop_time += (static_cast<double>(clock() - t_start)) / CLOCKS_PER_SEC * 1000;
 		outer_loop_time /= Grids->t;
 #endif
@@ -26,128 +26,13 @@
 
 #include "../inc/stdafx.h"
 
-// Lattice velocities
-#if (L_DIMS == 3) && defined L_USE_KBC_COLLISION
-
-// D3Q27
-const int c[3][L_NUM_VELS] =
-{
-	{ 1, -1, 0, 0, 0, 0, 0, 0, 0, 0, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, -1, 1, -1, 1, 1, -1, 0 },
-	{ 0, 0, 1, -1, 0, 0, 1, -1, 1, -1, 0, 0, 0, 0, 1, -1, -1, 1, 1, -1, -1, 1, 1, -1, -1, 1, 0 },
-	{ 0, 0, 0, 0, 1, -1, 1, -1, -1, 1, 1, -1, -1, 1, 0, 0, 0, 0, 1, -1, 1, -1, 1, -1, 1, -1, 0 }
-};
-
-const int c_opt[L_NUM_VELS][3] =
-{
-	{ 1, 0, 0 },
-	{ -1, 0, 0 },
-	{ 0, 1,	0 },
-	{ 0, -1, 0 },
-	{ 0, 0,	1 },
-	{ 0, 0,	-1 },
-	{ 0, 1,	1 },
-	{ 0, -1, -1 },
-	{ 0, 1, -1 },
-	{ 0, -1, 1 },
-	{ 1, 0,	1 },
-	{ -1, 0, -1 },
-	{ 1, 0,	-1 },
-	{ -1, 0, 1 },
-	{ 1, 1,	0 },
-	{ -1, -1, 0 },
-	{ 1, -1, 0 },
-	{ -1, 1, 0 },
-	{ 1, 1,	1 },
-	{ -1, -1, -1 },
-	{ -1, -1, 1, },
-	{ 1, 1,	-1 },
-	{ -1, 1, 1 },
-	{ 1, -1, -1 },
-	{ 1, -1, 1 },
-	{ -1, 1, -1 },
-	{ 0, 0,	0 }
-};
-
-#elif(L_DIMS == 3) && !defined L_USE_KBC_COLLISION
-
-// D3Q19
-const int c[3][L_NUM_VELS] =
-{
-	{1,	-1,  0,  0,  0,  0,  1, -1,  1, -1,  0,  0,  0,  0,  1, -1, -1,  1,  0 },
-	{0,  0,  1, -1,  0,  0,  1, -1, -1,  1,  1, -1,  1, -1,  0,  0,  0,  0,  0 },
-	{0,  0,  0,  0,  1, -1,  0,  0,  0,  0,  1, -1, -1,  1,  1, -1,  1, -1,  0 }
-};
-
-const int c_opt[L_NUM_VELS][3] =
-{
-	{ 1, 0, 0 },
-	{ -1, 0, 0 },
-	{ 0, 1, 0 },
-	{ 0, -1, 0 },
-	{ 0, 0, 1 },
-	{ 0, 0, -1 },
-	{ 1, 1, 0 },
-	{ -1, -1, 0 },
-	{ 1, -1, 0 },
-	{ -1, 1, 0 },
-	{ 0, 1, 1 },
-	{ 0, -1, -1 },
-	{ 0, 1, -1 },
-	{ 0, -1, 1 },
-	{ 1, 0, 1 },
-	{ -1, 0, -1 },
-	{ -1, 0, 1 },
-	{ 1, 0, -1 },
-	{ 0, 0, 0, }
-};
-
-#else
-
-// D2Q9
-const int c[3][L_NUM_VELS] =
-{
-	{ 1, -1, 0, 0, 1, -1, 1, -1, 0 },
-	{ 0, 0, 1, -1, 1, -1, -1, 1, 0 },
-	{ 0, 0, 0, 0, 0, 0, 0, 0, 0 }
-};
-
-const int c_opt[L_NUM_VELS][3] =
-{
-	{ 1, 0, 0 },
-	{ -1, 0, 0 },
-	{ 0, 1, 0 },
-	{ 0, -1, 0 },
-	{ 1, 1, 0 },
-	{ -1, -1, 0 },
-	{ 1, -1, 0 },
-	{ -1, 1, 0 },
-	{ 0, 0, 0, }
-};
-
-#endif
-
-// Weights for D2Q9, D3Q19 and D3Q27 models
-#if (L_DIMS == 3) && defined L_USE_KBC_COLLISION
-
-const double w[L_NUM_VELS] =
-{ 2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0, 2.0 / 27.0,
-1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0, 1.0 / 54.0,
-1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0, 1.0 / 216.0,
-8.0 / 27.0 };
-
-#elif (L_DIMS == 3) && !defined L_USE_KBC_COLLISION
-
-const double w[L_NUM_VELS] =
-{1.0/18.0, 1.0/18.0, 1.0/18.0, 1.0/18.0, 1.0/18.0, 1.0/18.0,
-1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0, 1.0/36.0,
-1.0/3.0};
-
-#else
-
-const double w[L_NUM_VELS] =
-{ 1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 9.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 1.0 / 36.0, 4.0 / 9.0 };
-
-#endif
+// Storage for the lattice descriptors (velocities and weights are defined in LatticeDescriptor.h)
+constexpr int LatticeDescriptor<2, 9>::c[LatticeDescriptor<2, 9>::vels][3];
+constexpr double LatticeDescriptor<2, 9>::w[LatticeDescriptor<2, 9>::vels];
+constexpr int LatticeDescriptor<3, 19>::c[LatticeDescriptor<3, 19>::vels][3];
+constexpr double LatticeDescriptor<3, 19>::w[LatticeDescriptor<3, 19>::vels];
+constexpr int LatticeDescriptor<3, 27>::c[LatticeDescriptor<3, 27>::vels][3];
+constexpr double LatticeDescriptor<3, 27>::w[LatticeDescriptor<3, 27>::vels];
 
 // Lattice sound speed
 const double cs = 1.0 / sqrt(3.0);
\ No newline at end of file